@@ -0,0 +1,53 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "skse64/GameReferences.h"
+
+#include "spatial_index.h"
+#include "RE/offsets.h"
+
+
+// Caches the expensive per-actor state the main loop needs (whether the ragdoll is in the world, whether it can be, the collision group and self-collision eligibility),
+// and only recomputes it when something that could affect it changes: the actor crosses an activation radius, its cell, 3d or animation graphs change,
+// its knock state changes, or we add/remove its ragdoll ourselves. Every actor is also re-checked every actorStateAuditInterval seconds to catch anything else.
+struct ActorStateTracker
+{
+	struct State
+	{
+		UInt32 handle = 0;
+		TESObjectCELL *cell = nullptr;
+		NiNode *root = nullptr;
+		void *graphManager = nullptr;
+		void *graphs = nullptr;
+		UInt32 numGraphs = 0;
+		double refreshTime = -1.0;
+		UInt16 collisionGroup = 0;
+		KnockState knockState = KnockState::Normal;
+		UInt8 rangeZone = 0;
+		bool isAddedToWorld = false;
+		bool canAddToWorld = false;
+		bool canSelfCollide = false;
+		bool isDirty = true;
+		bool isPresent = false;
+	};
+
+	// Matches up the cached state with this frame's actors and forgets actors that are gone
+	void BeginFrame(const std::vector<SpatialIndex::Entry> &entries);
+
+	// Valid until the next BeginFrame()
+	inline State & GetState(int entryIndex) { return *frameStates[entryIndex]; }
+
+	// Safe to call from multiple threads for different actors
+	bool NeedsRefresh(State &state, Actor *actor, UInt8 rangeZone, double now) const;
+
+	void Invalidate(Actor *actor);
+	void Clear();
+
+private:
+	std::unordered_map<Actor *, State> states{};
+	std::vector<State *> frameStates{};
+};
+
+extern ActorStateTracker g_actorStateTracker;
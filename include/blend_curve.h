@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <string_view>
+
+
+// Blend curves are plain values: a type tag plus a duration. Every curve type is baked at compile time into a table over normalized time [0, 1],
+// so evaluating a curve is a table lookup and a lerp regardless of the type.
+struct BlendCurve
+{
+	enum class Type : UInt8
+	{
+		Linear, // t
+		Power, // t^2
+		Smoothstep, // 3t^2 - 2t^3
+		Exponential, // 1 - e^(-kt), normalized
+		SpringCritical, // critically damped spring step response, normalized
+		Count,
+	};
+
+	static constexpr int numSegments = 64;
+	using Table = std::array<float, numSegments + 1>;
+
+	BlendCurve(double duration = 1.0, Type type = Type::Linear) : duration(duration), type(type) {}
+
+	inline float GetBlendValueAtTime(double time) const;
+
+	double duration = 1.0;
+	Type type = Type::Linear;
+};
+
+bool GetBlendCurveTypeFromName(std::string_view name, BlendCurve::Type &type);
+const char * GetBlendCurveName(BlendCurve::Type type);
+
+
+namespace BlendCurveTables {
+	constexpr double exponentialRate = 5.0;
+	constexpr double springFrequency = 8.0;
+
+	// e^x for x <= 0. Halve x until the series converges quickly, then square back up.
+	constexpr double Exp(double x)
+	{
+		int numHalvings = 0;
+		while (x < -0.5) {
+			x *= 0.5;
+			++numHalvings;
+		}
+
+		double sum = 1.0;
+		double term = 1.0;
+		for (int i = 1; i < 16; ++i) {
+			term *= x / i;
+			sum += term;
+		}
+
+		for (int i = 0; i < numHalvings; ++i) {
+			sum *= sum;
+		}
+		return sum;
+	}
+
+	constexpr double Evaluate(BlendCurve::Type type, double t)
+	{
+		switch (type) {
+		case BlendCurve::Type::Power:
+			return t * t;
+		case BlendCurve::Type::Smoothstep:
+			return t * t * (3.0 - 2.0 * t);
+		case BlendCurve::Type::Exponential:
+			return (1.0 - Exp(-exponentialRate * t)) / (1.0 - Exp(-exponentialRate));
+		case BlendCurve::Type::SpringCritical:
+			return (1.0 - (1.0 + springFrequency * t) * Exp(-springFrequency * t)) / (1.0 - (1.0 + springFrequency) * Exp(-springFrequency));
+		default:
+			return t;
+		}
+	}
+
+	constexpr std::array<BlendCurve::Table, (size_t)BlendCurve::Type::Count> Bake()
+	{
+		std::array<BlendCurve::Table, (size_t)BlendCurve::Type::Count> tables{};
+		for (size_t type = 0; type < tables.size(); ++type) {
+			for (int i = 0; i <= BlendCurve::numSegments; ++i) {
+				tables[type][i] = (float)Evaluate((BlendCurve::Type)type, double(i) / BlendCurve::numSegments);
+			}
+		}
+		return tables;
+	}
+
+	inline constexpr std::array<BlendCurve::Table, (size_t)BlendCurve::Type::Count> tables = Bake();
+}
+
+inline float BlendCurve::GetBlendValueAtTime(double time) const
+{
+	if (duration <= 0.0) return 1.f;
+
+	float t = (float)std::clamp(time / duration, 0.0, 1.0) * numSegments;
+	int i = std::min((int)t, numSegments - 1);
+	const Table &table = BlendCurveTables::tables[(size_t)type];
+	return table[i] + (table[i + 1] - table[i]) * (t - i);
+}
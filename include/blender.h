@@ -6,6 +6,9 @@
 #include <Common/Base/hkBase.h>
 
 #include "RE/havok_behavior.h"
+#include "pose_blend.h"
+#include "blend_curve.h"
+#include "pose_buffer_pool.h"
 
 struct Blender
 {
@@ -16,39 +19,52 @@ struct Blender
 		RagdollToAnim,
 		CurrentRagdollToAnim,
 		RagdollToCurrentRagdoll,
+		InertializedAnimToRagdoll,
+		InertializedRagdollToAnim,
 	};
 
-	struct Curve
+	// Inertialized blends don't crossfade between two full poses. Instead, the offset from the target pose (and its rate of change) is recorded once when the blend starts,
+	// and then decays to zero over the blend duration. Offsets are stored relative to the target pose.
+	struct InertializationOffset
 	{
-		Curve(double duration);
-		virtual float GetBlendValueAtTime(double time);
-
-		double duration = 1.0;
+		float translation[4]; // source - target
+		float rotation[4]; // source * inverse(target)
+		float scale[4]; // source - target
+		// Rate of change of each offset, relative to its initial magnitude
+		float translationVelocity;
+		float rotationVelocity;
+		float scaleVelocity;
 	};
 
-	struct PowerCurve : Curve
+	enum class ResumeFrom : UInt8
 	{
-		PowerCurve(double duration, double power);
-		virtual float GetBlendValueAtTime(double time) override;
-
-		double a;
-		double b;
+		Nothing,
+		CurrentPose, // started while crossfading - currentPose holds the last blended pose
+		Offsets, // started while inertializing - the last blended pose is reconstructed from the offsets
 	};
 
-	void StartBlend(BlendType blendType, double currentTime, const Curve &blendCurve);
+	void StartBlend(BlendType blendType, double currentTime, const BlendCurve &blendCurve);
 
 	inline void StopBlend() { isActive = false; }
 
 	bool Update(const struct ActiveRagdoll &ragdoll, const hkbRagdollDriver &driver, hkbGeneratorOutput &inOut, double frameTime);
 
-	std::vector<hkQsTransform> initialPose{};
-	std::vector<hkQsTransform> currentPose{};
-	std::vector<hkQsTransform> scratchPose{};
+	static inline bool IsInertialized(BlendType blendType) { return blendType == BlendType::InertializedAnimToRagdoll || blendType == BlendType::InertializedRagdollToAnim; }
+
+	void StartInertialization(const struct ActiveRagdoll &ragdoll, const hkQsTransform *targetPose, int numPoses, double frameTime);
+	void ApplyPreviousInertialization(const struct ActiveRagdoll &ragdoll, hkQsTransform *poseOut, int numPoses, double frameTime);
+
+	// These point into the ragdoll's pooled pose buffers
+	PoseBuffer<hkQsTransform> initialPose{};
+	PoseBuffer<hkQsTransform> currentPose{};
+	PoseBuffer<InertializationOffset> offsets{};
 	double startTime = 0.0;
+	double previousStartTime = 0.0;
+	double previousDuration = 0.0;
 	BlendType type = BlendType::AnimToRagdoll;
-	Curve curve{ 1.0 };
+	BlendType previousType = BlendType::AnimToRagdoll;
+	ResumeFrom resumeFrom = ResumeFrom::Nothing;
+	BlendCurve curve{ 1.0 };
 	bool isFirstBlendFrame = false;
 	bool isActive = false;
 };
-
-void BlendPoses(const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, float *weights, int numPoses);
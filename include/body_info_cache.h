@@ -0,0 +1,54 @@
+#pragma once
+
+#include <shared_mutex>
+
+#include <Physics/Dynamics/Entity/hkpRigidBody.h>
+
+#include "skse64/GameReferences.h"
+
+#include "flat_hash_map.h"
+
+
+namespace BodyFlags {
+	enum : UInt8
+	{
+		Hand = 1 << 0,
+		Weapon = 1 << 1,
+		Held = 1 << 2,
+		Left = 1 << 3, // left hand, left weapon or held in the left hand
+		Higgs = 1 << 4, // a hand, weapon or held object that is on the higgs layer
+		InVehicle = 1 << 5, // owned by an actor that is riding something
+	};
+}
+
+// Everything the contact callbacks want to know about a rigid body, which would otherwise be looked up again for every contact point the body has.
+// refr and actor are not reference counted. The cache is cleared right before every physics step and when the world changes, and the contact callbacks
+// that read it run during the step, when the body is in the world and so its owner's 3d (and the owner) can't go away. Anything that keeps the refr
+// past the callback, like a hit, takes an NiPointer to it.
+struct BodyInfo
+{
+	TESObjectREFR *refr = nullptr; // owner of the body, if any
+	Actor *actor = nullptr; // the owner if it's an actor
+	UInt8 flags = 0;
+
+	inline bool Has(UInt8 flag) const { return flags & flag; }
+};
+
+// Per-body metadata, filled in lazily by the contact callbacks and dropped right before each physics step and when the world changes.
+// The collision filter callback only ever sees filter infos and not bodies, so it can't use this.
+struct BodyInfoCache
+{
+	// Safe to call from multiple threads. Returns a copy, since another thread can insert (and reallocate) at any time.
+	BodyInfo Get(hkpRigidBody *body);
+
+	// Main thread only, while no physics step is running
+	void Clear();
+
+private:
+	static BodyInfo Compute(hkpRigidBody *body);
+
+	FlatHashMap<hkpRigidBody *, BodyInfo> infos{};
+	std::shared_mutex lock{};
+};
+
+extern BodyInfoCache g_bodyInfoCache;
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <Physics/Dynamics/Entity/hkpRigidBody.h>
+#include <Physics/Dynamics/World/hkpWorld.h>
+
+
+// Collects collision filter refreshes over the frame and runs them all at once, taking each world's write lock a single time.
+// A body queued more than once is only refreshed once, with the most thorough of the requested modes.
+// Bodies are not referenced while queued, so the queue must be flushed before anything can remove them, e.g. at the end of the main loop.
+struct CollisionFilterUpdateQueue
+{
+	void Queue(hkpRigidBody *body, hkpUpdateCollisionFilterOnEntityMode mode);
+	void Flush();
+	void Clear();
+
+private:
+	struct Request
+	{
+		hkpRigidBody *body;
+		hkpWorld *world;
+		hkpUpdateCollisionFilterOnEntityMode mode;
+	};
+
+	std::vector<Request> requests{};
+	std::unordered_map<hkpRigidBody *, int> requestIndices{};
+};
+
+extern CollisionFilterUpdateQueue g_collisionFilterUpdateQueue;
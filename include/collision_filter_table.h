@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+
+#include "skse64/GameForms.h"
+
+#include "higgsinterface001.h"
+#include "collision_group_flags.h"
+
+
+// The collision filter policy (biped self-collision, player vs. character controllers, player vs. bipeds, ...) evaluated ahead of time
+// for every combination of layer class, same group or not, and the GroupFlags of both groups. The filter callback then does one lookup per pair
+// instead of walking the policy and reading the config on every call.
+// Like ContactDispatchTable, it is rebuilt on the main thread when the config options or the higgs layer change, into whichever of the two copies
+// isn't published. The player and held groups are GroupFlags, so a change to those doesn't need a rebuild.
+// Before the first build everything is Continue, which is the same as not having a filter callback at all.
+struct CollisionFilterTable
+{
+	using Result = HiggsPluginAPI::IHiggsInterface001::CollisionFilterComparisonResult;
+
+	// The only layers the policy tells apart
+	enum class LayerClass : UInt8
+	{
+		Other,
+		Biped,
+		CharController,
+		Higgs,
+	};
+
+	inline Result Get(UInt32 filterInfoA, UInt32 filterInfoB, UInt8 flagsA, UInt8 flagsB) const
+	{
+		const Table &table = tables[current.load(std::memory_order_acquire)];
+		UInt8 classA = table.layerClasses[filterInfoA & 0x7f];
+		UInt8 classB = table.layerClasses[filterInfoB & 0x7f];
+		bool isSameGroup = (filterInfoA >> 16) == (filterInfoB >> 16);
+		return (Result)table.results[GetIndex(classA, classB, isSameGroup, flagsA, flagsB)];
+	}
+
+	// Rebuilds the table if anything it depends on has changed. Main thread only.
+	void Validate(UInt32 higgsLayer);
+
+	struct Options
+	{
+		bool doBipedNonSelfCollision;
+		bool enablePlayerBipedCollision;
+	};
+
+	// The policy itself, for a single combination. This is what the table is built from.
+	static Result Evaluate(LayerClass classA, LayerClass classB, bool isSameGroup, UInt8 flagsA, UInt8 flagsB, const Options &options);
+
+private:
+	static constexpr int NumFlagBits = 5; // the GroupFlags the policy looks at
+	static constexpr UInt8 FlagsMask = (1 << NumFlagBits) - 1;
+	static constexpr int NumResults = 4 * 4 * 2 * (1 << NumFlagBits) * (1 << NumFlagBits);
+
+	static inline int GetIndex(UInt8 classA, UInt8 classB, bool isSameGroup, UInt8 flagsA, UInt8 flagsB)
+	{
+		return (((((classA << 2) | classB) << 1 | (int)isSameGroup) << NumFlagBits | (flagsA & FlagsMask)) << NumFlagBits) | (flagsB & FlagsMask);
+	}
+
+	struct Table
+	{
+		UInt8 layerClasses[128]{};
+		UInt8 results[NumResults]{};
+	};
+
+	void Build(Table &table, UInt32 higgsLayer);
+
+	Table tables[2]{};
+	std::atomic<int> current = 0;
+	UInt32 optionsVersion = 0;
+	UInt32 builtHiggsLayer = 0;
+	bool isBuilt = false;
+};
+
+extern CollisionFilterTable g_collisionFilterTable;
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+
+// What the collision filter needs to know about each collision group (the upper 16 bits of a filter info).
+namespace GroupFlags {
+	enum : UInt8
+	{
+		SelfCollidable = 1 << 0, // biped bones in the group collide with each other
+		Hittable = 1 << 1, // actor without a ragdoll that we still want to hit through its char controller
+		ActiveBiped = 1 << 2, // actor whose ragdoll we added to the world
+		Player = 1 << 3,
+		Held = 1 << 4, // actor held by higgs
+	};
+}
+
+// One flags byte per collision group, so the filter callback can answer with a single load instead of hashing into sets.
+// The main thread changes a staging copy over the frame, and Publish() makes the changes visible to the filter all at once.
+// Two published copies alternate, so that a filter query running on another thread never sees a copy that is being written.
+struct CollisionGroupFlags
+{
+	CollisionGroupFlags();
+
+	// Any thread. Sees the flags as of the last Publish().
+	inline UInt8 Get(UInt16 group) const { return published[current.load(std::memory_order_acquire)][group]; }
+
+	// Main thread only. Sees the flags including changes that haven't been published yet.
+	inline UInt8 GetStaged(UInt16 group) const { return staging[group]; }
+
+	inline void Add(UInt16 group, UInt8 flags)
+	{
+		if ((staging[group] & flags) == flags) return;
+		staging[group] |= flags;
+		isDirty = true;
+	}
+
+	inline void Remove(UInt16 group, UInt8 flags)
+	{
+		if (!(staging[group] & flags)) return;
+		staging[group] &= ~flags;
+		isDirty = true;
+	}
+
+	// For flags that only a couple of groups have at any time (the player, held actors): takes the flag away from whichever groups it was last assigned to, and gives it to these
+	void Assign(UInt8 flag, const UInt16 *groups, int numGroups);
+
+	// Main thread only, before the filter is next needed (e.g. before flushing the filter update queue)
+	void Publish();
+
+	// Main thread only, while nothing can be running the filter
+	void Reset();
+
+private:
+	static constexpr int NumGroups = 1 << 16;
+
+	std::unique_ptr<UInt8[]> staging;
+	std::unique_ptr<UInt8[]> published[2];
+	std::atomic<int> current = 0;
+	bool isDirty = false;
+
+	std::vector<UInt16> assignedGroups[8]{}; // for each flag bit, the groups it was given to by Assign()
+};
+
+extern CollisionGroupFlags g_collisionGroupFlags;
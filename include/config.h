@@ -5,14 +5,46 @@
 #include "skse64/NiNodes.h"
 #include "skse64/GameData.h"
 
+#include "blend_curve.h"
+#include "hit_classification.h"
+
 
 namespace Config {
+	// Per-tier settings for active ragdoll level of detail. Tiers are picked by distance to the player; interacting with an actor always bumps them to the full tier.
+	struct RagdollLodOptions {
+		float maxDistance;
+		bool usePoweredController; // if false, only the rigidbody controller drives the ragdoll
+		bool loosenConstraints;
+		bool disableGravity;
+		bool readStress;
+		bool keyframed; // keyframe all bones to the animation instead of driving them
+	};
+
 	struct Options {
 		float activeRagdollStartDistance = 50.f;
 		float activeRagdollEndDistance = 60.f;
 
+		RagdollLodOptions lodFull{ 60.f, true, true, true, true, false };
+		RagdollLodOptions lodRigidBody{ 60.f, false, false, true, true, false };
+		RagdollLodOptions lodKeyframed{ 60.f, false, false, false, false, true }; // anything past lodRigidBody.maxDistance lands here, until activeRagdollEndDistance
+		float lodHysteresisDistance = 2.f;
+
+		bool parallelActorGather = false;
+		int actorGatherWorkerThreads = 2;
+		double actorStateAuditInterval = 1.0;
+
+		int maxActiveRagdolls = 0; // <= 0 for no limit
+		double activeRagdollCostBudgetMicroseconds = 0.0; // <= 0 for no limit
+		double budgetPromoteCooldown = 1.0;
+		double budgetDemoteCooldown = 2.0;
+		double budgetInteractionMemoryTime = 5.0;
+		float budgetHysteresisDistance = 5.f;
+
 		double blendInTime = 0.2;
+		BlendCurve::Type blendInCurve = BlendCurve::Type::Linear; // only for crossfaded blend-ins, inertialized ones (inertializeBlendIn) always decay along a quintic
 		double getUpBlendTime = 0.2;
+		BlendCurve::Type getUpBlendCurve = BlendCurve::Type::Linear;
+		bool inertializeBlendIn = false; // off by default so that existing setups keep the crossfade (and blendInCurve)
 
 		bool enableKeyframes = true;
 		double blendInKeyframeTime = 0.05;
@@ -21,6 +53,9 @@ namespace Config {
 		double hitCooldownTimeFallback = 1.0;
 		double physicsHitRecoveryTime = 0.01;
 
+		bool recordContactEvents = false; // for tuning hit detection offline, see tools/contact_replay.cpp
+		std::string contactRecordingPath = "Data/SKSE/Plugins/activeragdoll_contacts.bin";
+
 		double thrownObjectLingerTime = 5.0;
 
 		double worldChangedWaitTime = 0.4;
@@ -206,6 +241,20 @@ namespace Config {
 		std::set<std::string, std::less<>> aggressionExcludeRaces;
 	};
 	extern Options options; // global object containing options
+	extern UInt32 optionsVersion; // incremented every time the options are (re)read, for caches derived from them
+
+	inline HitClassificationOptions GetHitClassificationOptions()
+	{
+		return {
+			options.hitStabDirectionThreshold,
+			options.hitStabSpeedThreshold,
+			options.hitPunchDirectionThreshold,
+			options.hitPunchSpeedThreshold,
+			options.hitSwingSpeedThreshold,
+			options.hitRequiredHandSpeedRoomspace,
+			options.disableHitIfSheathed
+		};
+	}
 
 
 	// Fills Options struct from INI file
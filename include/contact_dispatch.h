@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+
+#include "skse64/GameForms.h"
+
+
+// Which parts of ContactListener::contactPointCallback care about a contact between two collision layers.
+namespace ContactHandler {
+	enum : UInt8
+	{
+		CharControllerVsClutter = 1 << 0, // only when disableClutterVsCharacterControllerCollisionForActiveActors is on
+		BipedVsClutter = 1 << 1,
+		BipedVsBiped = 1 << 2, // only when one of the biped vs biped options is on
+		Higgs = 1 << 3, // exactly one body is on the higgs layer
+		BothHiggs = 1 << 4,
+	};
+}
+
+// 128x128 table of ContactHandler bits for every pair of collision layers, so the contact callback does one load instead of a chain of layer comparisons,
+// and returns straight away for the pairs we don't care about (e.g. clutter vs static).
+// The table is rebuilt on the main thread when the config options or the higgs layer change. There are two copies and the callbacks read whichever one was
+// published last, so a rebuild never touches a table that a physics thread might be reading.
+struct ContactDispatchTable
+{
+	inline UInt8 Get(UInt32 layerA, UInt32 layerB) const
+	{
+		return tables[current.load(std::memory_order_acquire)][layerA & 0x7f][layerB & 0x7f];
+	}
+
+	// Rebuilds the table if anything it depends on has changed. Main thread only.
+	void Validate(UInt32 higgsLayer);
+
+private:
+	void Build(UInt8 (&table)[128][128], UInt32 higgsLayer);
+
+	UInt8 tables[2][128][128]{};
+	std::atomic<int> current = 0;
+	UInt32 optionsVersion = 0;
+	UInt32 builtHiggsLayer = 0;
+	bool isBuilt = false;
+};
+
+extern ContactDispatchTable g_contactDispatchTable;
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "hit_classification.h"
+
+// On-disk format of the contact event recording, shared by the in-game recorder and the offline replay tool.
+// A file header followed by records, each a RecordHeader and then a payload of the given size. Everything is little-endian and packed.
+// Readers should skip records of unknown types using the size, so that new record types can be added without breaking old tools.
+namespace ContactRecord {
+	constexpr UInt32 Magic = 0x52435241; // "ARCR"
+	constexpr UInt32 Version = 2;
+
+	enum class Type : UInt8
+	{
+		Step = 1, // start of a physics step
+		Config, // the options in effect from here on
+		ControllerSample, // one per controller pose update, in order with the contacts, so the hand speed and direction can be rebuilt
+		Contact,
+	};
+
+#pragma pack(push, 1)
+	struct FileHeader
+	{
+		UInt32 magic;
+		UInt32 version;
+	};
+
+	struct RecordHeader
+	{
+		Type type;
+		UInt16 size; // of the payload that follows
+	};
+
+	struct Step
+	{
+		double frameTime; // seconds
+		UInt32 index;
+	};
+
+	struct Config
+	{
+		HitClassificationOptions hit;
+		double hitCooldownTimeStoppedColliding;
+		double hitCooldownTimeFallback;
+	};
+
+	struct ControllerSample
+	{
+		double time; // seconds, on the same clock as Step::frameTime
+		UInt8 isLeft;
+		float velocity[3]; // worldspace
+		float avgVelocity[3];
+		float avgSpeed;
+	};
+
+	struct Contact
+	{
+		UInt64 hitBody; // body addresses, only meaningful as ids within one recording
+		UInt64 hittingBody;
+		UInt64 hitRefr;
+		UInt8 hitLayer;
+		UInt8 hittingLayer;
+		UInt8 isLeft;
+		UInt8 isTwoHanding;
+		float position[3]; // havok units
+		float pointVelocity[3]; // of the hitting body at the contact, havok units
+		float referenceDirection[3]; // weapon forward for stabs or the hand's finger direction for punches, that input.stabAmount or input.punchAmount is the dot product of the hand direction with. Zero if neither applies.
+		HitClassificationInput input;
+		HitClassification result; // what the game decided at the time
+	};
+#pragma pack(pop)
+}
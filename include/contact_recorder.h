@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+#include "contact_record.h"
+
+
+// Writes the hit contacts, controller velocity samples and the options they were classified with to a binary file (see contact_record.h),
+// so that hit classification can be tuned and regression-tested offline with tools/contact_replay.cpp.
+// Recording is turned on and off by the recordContactEvents option, and a new recording overwrites the previous one.
+struct ContactRecorder
+{
+	// Opens or closes the recording to follow the config, and marks the start of a physics step. Main thread only.
+	void BeginStep(double frameTime);
+
+	inline bool IsRecording() const { return isRecording.load(std::memory_order_relaxed); }
+
+	// Safe to call from any thread
+	void RecordContact(const ContactRecord::Contact &contact);
+	void RecordControllerSample(const ContactRecord::ControllerSample &sample);
+
+	void Close();
+
+private:
+	template <typename T>
+	void Write(ContactRecord::Type type, const T &payload)
+	{
+		ContactRecord::RecordHeader header{ type, (UInt16)sizeof(T) };
+		file.write((const char *)&header, sizeof(header));
+		file.write((const char *)&payload, sizeof(T));
+	}
+
+	std::ofstream file{};
+	std::mutex lock{};
+	std::atomic<bool> isRecording = false;
+	UInt32 optionsVersion = 0; // of the last config record written
+	UInt32 failedOptionsVersion = 0;
+	UInt32 stepIndex = 0;
+};
+
+extern ContactRecorder g_contactRecorder;
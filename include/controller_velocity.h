@@ -0,0 +1,64 @@
+#pragma once
+
+#include <deque>
+#include <iterator>
+#include <numeric>
+
+
+// Average of the last few controller velocities, for the hand speed and direction used by hit classification and shoves.
+// Templated on the vector type so that the offline replay tool can rebuild the same values from a recording without the game's types.
+// Vector needs + and / by a scalar, and VectorLength() and VectorNormalized() that can be found by argument-dependent lookup.
+template <typename Vector>
+struct ControllerVelocityData
+{
+	static constexpr int DefaultWindowSize = 5;
+
+	std::deque<Vector> velocities;
+	Vector avgVelocity{};
+	float avgSpeed = 0.f;
+
+	ControllerVelocityData(int windowSize = DefaultWindowSize) : velocities(windowSize, Vector()) {}
+
+	// Replaces the oldest velocity in the window
+	void Add(const Vector &velocity)
+	{
+		velocities.pop_back();
+		velocities.push_front(velocity);
+		Recompute();
+	}
+
+	void RecomputeAverageVelocity()
+	{
+		avgVelocity = std::accumulate(velocities.begin(), velocities.end(), Vector()) / velocities.size();
+	}
+
+	void RecomputeAverageSpeed()
+	{
+		float speed = 0;
+		for (Vector &velocity : velocities) {
+			speed += VectorLength(velocity);
+		}
+		speed /= std::size(velocities);
+		avgSpeed = speed;
+	}
+
+	void Recompute()
+	{
+		RecomputeAverageVelocity();
+		RecomputeAverageSpeed();
+	}
+};
+
+// Direction and roomspace speed of the hand that made a contact. When two-handing, both hands move the weapon so both are taken into account.
+template <typename Vector>
+void GetHandMotion(const ControllerVelocityData<Vector> (&data)[2], bool isLeft, bool isTwoHanding, Vector &direction, float &speed)
+{
+	if (isTwoHanding) {
+		direction = VectorNormalized(data[0].avgVelocity + data[1].avgVelocity);
+		speed = data[0].avgSpeed > data[1].avgSpeed ? data[0].avgSpeed : data[1].avgSpeed;
+	}
+	else {
+		direction = VectorNormalized(data[isLeft].avgVelocity);
+		speed = data[isLeft].avgSpeed;
+	}
+}
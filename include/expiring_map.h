@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "flat_hash_map.h"
+
+
+// Map whose entries carry an expiry time and are dropped by Expire(now), for cooldown and linger tables.
+// Expiry times are kept in a min-heap with lazy deletion, so Expire() only looks at entries that are actually due instead of sweeping the whole table.
+// Pushing an expiry time back (the usual case for refreshing a cooldown) just updates the entry; the entry is re-queued at its new time when its old heap node comes up.
+// Only moving an expiry time earlier pushes a new heap node, and heap nodes that no longer match their entry are skipped when they come up.
+// Times can be on any clock, as long as the same one is used for every call on a given map.
+template <typename K, typename V, typename Hash = FlatHash>
+struct ExpiringMap
+{
+	inline int size() const { return entries.size(); }
+	inline bool empty() const { return entries.empty(); }
+
+	inline V * find(const K &key)
+	{
+		Entry *entry = entries.find(key);
+		return entry ? &entry->value : nullptr;
+	}
+
+	inline const V * find(const K &key) const { return const_cast<ExpiringMap *>(this)->find(key); }
+	inline bool count(const K &key) const { return entries.count(key); }
+
+	// Inserts or overwrites the entry
+	V & Set(const K &key, const V &value, double expiryTime)
+	{
+		bool isNew = !entries.count(key);
+		Entry &entry = entries[key];
+		entry.value = value;
+		entry.expiryTime = expiryTime;
+		if (isNew || expiryTime < entry.queuedTime) {
+			Push(key, entry);
+		}
+		return entry.value;
+	}
+
+	// Moves the expiry time of an existing entry, returns false if there is no such entry
+	bool SetExpiryTime(const K &key, double expiryTime)
+	{
+		Entry *entry = entries.find(key);
+		if (!entry) return false;
+
+		entry->expiryTime = expiryTime;
+		if (expiryTime < entry->queuedTime) {
+			Push(key, *entry);
+		}
+		return true;
+	}
+
+	inline bool erase(const K &key) { return entries.erase(key); }
+
+	// Sets every entry's expiry time to getExpiryTime(key, value), e.g. after the durations the expiry times were worked out from have changed
+	template <typename F>
+	void UpdateExpiryTimes(F &&getExpiryTime)
+	{
+		heap.clear();
+		entries.ForEach([this, &getExpiryTime](const K &key, Entry &entry) {
+			entry.expiryTime = getExpiryTime(key, (const V &)entry.value);
+			Push(key, entry);
+		});
+	}
+
+	// Removes every entry whose expiry time is before now
+	void Expire(double now)
+	{
+		while (!heap.empty() && heap.front().time < now) {
+			std::pop_heap(heap.begin(), heap.end(), HeapOrder{});
+			Node node = std::move(heap.back());
+			heap.pop_back();
+
+			Entry *entry = entries.find(node.key);
+			if (!entry || entry->queuedTime != node.time) continue; // erased, or superseded by a newer node
+
+			if (entry->expiryTime < now) {
+				entries.erase(node.key);
+			}
+			else {
+				// Was refreshed since it was queued
+				Push(node.key, *entry);
+			}
+		}
+
+		if (entries.empty()) {
+			heap.clear();
+		}
+	}
+
+	void clear()
+	{
+		entries.clear();
+		heap.clear();
+	}
+
+private:
+	struct Entry
+	{
+		V value;
+		double expiryTime;
+		double queuedTime; // time of the heap node that is currently responsible for this entry
+	};
+
+	struct Node
+	{
+		double time;
+		K key;
+	};
+
+	struct HeapOrder
+	{
+		inline bool operator()(const Node &a, const Node &b) const { return a.time > b.time; }
+	};
+
+	void Push(const K &key, Entry &entry)
+	{
+		entry.queuedTime = entry.expiryTime;
+		heap.push_back({ entry.expiryTime, key });
+		std::push_heap(heap.begin(), heap.end(), HeapOrder{});
+	}
+
+	FlatHashMap<K, Entry, Hash> entries{};
+	std::vector<Node> heap{};
+};
+
+// ExpiringMap for tables where only the presence of the key matters
+template <typename K, typename Hash = FlatHash>
+struct ExpiringSet
+{
+	inline int size() const { return map.size(); }
+	inline bool empty() const { return map.empty(); }
+	inline bool count(const K &key) const { return map.count(key); }
+	inline void Set(const K &key, double expiryTime) { map.Set(key, UInt8{}, expiryTime); }
+	inline bool erase(const K &key) { return map.erase(key); }
+	inline void Expire(double now) { map.Expire(now); }
+	inline void clear() { map.clear(); }
+
+private:
+	ExpiringMap<K, UInt8, Hash> map{};
+};
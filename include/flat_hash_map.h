@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+// Hashes for the keys we use in flat tables: pointers, refr handles and pairs of pointers.
+// Pointers are aligned so the low bits carry no information; multiplying by a large odd constant spreads the rest over the high bits, which is what the table indexes with.
+struct FlatHash
+{
+	static inline uint64_t Mix(uint64_t x) { return x * 0x9E3779B97F4A7C15ull; }
+
+	inline uint64_t operator()(UInt32 value) const { return Mix(value); }
+
+	template <typename T>
+	inline uint64_t operator()(T *ptr) const { return Mix((uint64_t)ptr); }
+
+	template <typename A, typename B>
+	inline uint64_t operator()(const std::pair<A, B> &pair) const { return Mix((*this)(pair.first) ^ ((*this)(pair.second) >> 29)); }
+};
+
+// Open-addressing hash map with linear probing.
+// Erasing shifts the following entries of the probe run back instead of leaving tombstones, so lookups never slow down as entries come and go.
+// clear() keeps the capacity, so a table that is refilled every frame stops allocating once it has grown to its working size.
+template <typename K, typename V, typename Hash = FlatHash>
+struct FlatHashMap
+{
+	struct Slot
+	{
+		K key;
+		V value;
+	};
+
+	inline int size() const { return numEntries; }
+	inline bool empty() const { return numEntries == 0; }
+
+	inline V * find(const K &key)
+	{
+		if (numEntries == 0) return nullptr;
+		for (UInt32 i = HomeIndex(key);; i = (i + 1) & mask) {
+			if (!occupied[i]) return nullptr;
+			if (slots[i].key == key) return &slots[i].value;
+		}
+	}
+
+	inline const V * find(const K &key) const { return const_cast<FlatHashMap *>(this)->find(key); }
+	inline bool count(const K &key) const { return find(key) != nullptr; }
+
+	// Inserts a default value if the key isn't present
+	V & operator[](const K &key)
+	{
+		if ((UInt32)(numEntries + 1) * 4 > capacity() * 3) {
+			Grow();
+		}
+
+		UInt32 i = HomeIndex(key);
+		for (; occupied[i]; i = (i + 1) & mask) {
+			if (slots[i].key == key) return slots[i].value;
+		}
+
+		occupied[i] = true;
+		slots[i].key = key;
+		slots[i].value = V{};
+		++numEntries;
+		return slots[i].value;
+	}
+
+	// Returns true if the key was newly inserted
+	inline bool insert(const K &key, const V &value = V{})
+	{
+		int oldNumEntries = numEntries;
+		(*this)[key] = value;
+		return numEntries != oldNumEntries;
+	}
+
+	bool erase(const K &key)
+	{
+		if (numEntries == 0) return false;
+		for (UInt32 i = HomeIndex(key);; i = (i + 1) & mask) {
+			if (!occupied[i]) return false;
+			if (slots[i].key == key) {
+				EraseAt(i);
+				return true;
+			}
+		}
+	}
+
+	// Erases every entry for which pred(key, value) returns true
+	template <typename F>
+	void EraseIf(F &&pred)
+	{
+		if (numEntries == 0) return;
+
+		// Start just after an empty slot. Backward shifts never move entries across an empty slot, so every entry is visited exactly once.
+		UInt32 start = 0;
+		while (occupied[start]) start = (start + 1) & mask;
+
+		UInt32 i = (start + 1) & mask;
+		for (UInt32 visited = 0; visited < capacity(); visited++) {
+			while (occupied[i] && pred(slots[i].key, slots[i].value)) {
+				EraseAt(i); // pulls a later entry into i, if any, so check i again
+			}
+			i = (i + 1) & mask;
+		}
+	}
+
+	template <typename F>
+	void ForEach(F &&func)
+	{
+		for (UInt32 i = 0; i < capacity(); i++) {
+			if (occupied[i]) func(slots[i].key, slots[i].value);
+		}
+	}
+
+	template <typename F>
+	void ForEach(F &&func) const
+	{
+		for (UInt32 i = 0; i < capacity(); i++) {
+			if (occupied[i]) func(slots[i].key, (const V &)slots[i].value);
+		}
+	}
+
+	void clear()
+	{
+		if (numEntries == 0) return;
+		std::fill(occupied.begin(), occupied.end(), (UInt8)false);
+		numEntries = 0;
+	}
+
+	void reserve(int count)
+	{
+		while ((UInt32)count * 4 > capacity() * 3) {
+			Grow();
+		}
+	}
+
+private:
+	inline UInt32 capacity() const { return (UInt32)slots.size(); }
+	inline UInt32 HomeIndex(const K &key) const { return (UInt32)(Hash{}(key) >> 32) & mask; }
+
+	void EraseAt(UInt32 hole)
+	{
+		occupied[hole] = false;
+		--numEntries;
+
+		// Shift back any entries further down the run that could live in the hole
+		for (UInt32 i = (hole + 1) & mask; occupied[i]; i = (i + 1) & mask) {
+			UInt32 home = HomeIndex(slots[i].key);
+			// The entry can move into the hole only if its home slot is not cyclically within (hole, i]
+			bool canMove = hole <= i ? (home <= hole || home > i) : (home <= hole && home > i);
+			if (canMove) {
+				slots[hole] = std::move(slots[i]);
+				occupied[hole] = true;
+				occupied[i] = false;
+				hole = i;
+			}
+		}
+	}
+
+	void Grow()
+	{
+		std::vector<Slot> oldSlots = std::move(slots);
+		std::vector<UInt8> oldOccupied = std::move(occupied);
+
+		UInt32 newCapacity = oldSlots.empty() ? 16 : (UInt32)oldSlots.size() * 2;
+		slots.assign(newCapacity, Slot{});
+		occupied.assign(newCapacity, (UInt8)false);
+		mask = newCapacity - 1;
+		numEntries = 0;
+
+		for (UInt32 i = 0; i < oldSlots.size(); i++) {
+			if (oldOccupied[i]) {
+				(*this)[oldSlots[i].key] = std::move(oldSlots[i].value);
+			}
+		}
+	}
+
+	std::vector<Slot> slots{};
+	std::vector<UInt8> occupied{};
+	UInt32 mask = 0;
+	int numEntries = 0;
+};
+
+template <typename K, typename Hash = FlatHash>
+struct FlatHashSet
+{
+	inline int size() const { return map.size(); }
+	inline bool empty() const { return map.empty(); }
+	inline bool count(const K &key) const { return map.count(key); }
+	inline bool insert(const K &key) { return map.insert(key); }
+	inline bool erase(const K &key) { return map.erase(key); }
+	inline void clear() { map.clear(); }
+	inline void reserve(int count) { map.reserve(count); }
+
+	template <typename F>
+	void EraseIf(F &&pred) { map.EraseIf([&pred](const K &key, UInt8) { return pred(key); }); }
+
+	template <typename F>
+	void ForEach(F &&func) const { map.ForEach([&func](const K &key, const UInt8 &) { func(key); }); }
+
+private:
+	FlatHashMap<K, UInt8, Hash> map{};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+// Deciding whether a contact between the player's hand/weapon and something else is a hit, and what kind.
+// This only depends on plain numbers so that the offline contact replay tool can build it outside of the game.
+
+
+struct HitClassificationOptions
+{
+	float stabDirectionThreshold;
+	float stabSpeedThreshold;
+	float punchDirectionThreshold;
+	float punchSpeedThreshold;
+	float swingSpeedThreshold;
+	float requiredHandSpeedRoomspace;
+	bool disableHitIfSheathed;
+};
+
+enum class HitWeaponType : UInt8
+{
+	Other,
+	Stabbing, // a weapon that can stab
+	Unarmed, // nothing equipped, or hand to hand
+};
+
+struct HitClassificationInput
+{
+	float hitSpeed; // point velocity of the hitting body at the contact, havok units
+	float stabAmount; // dot of the hand direction and the weapon's forward vector
+	float punchAmount; // dot of the hand direction and the hand's finger direction
+	float handSpeedRoomspace;
+	HitWeaponType weaponType;
+	bool hasWeaponNode; // the stab / punch amount could be computed
+	bool isWeaponDrawn;
+};
+
+enum class HitType : UInt8
+{
+	None,
+	Stab,
+	Punch,
+	Swing,
+};
+
+struct HitClassification
+{
+	HitType type;
+	bool isDisabled; // would be a hit, but the hand is too slow or the weapon is sheathed
+
+	inline bool IsHit() const { return type != HitType::None && !isDisabled; }
+};
+
+inline HitClassification ClassifyHit(const HitClassificationInput &input, const HitClassificationOptions &options)
+{
+	HitType type = HitType::None;
+
+	if (input.weaponType == HitWeaponType::Stabbing) {
+		if (input.hasWeaponNode && input.stabAmount > options.stabDirectionThreshold && input.hitSpeed > options.stabSpeedThreshold) {
+			type = HitType::Stab;
+		}
+	}
+	else if (input.weaponType == HitWeaponType::Unarmed) {
+		if (input.hasWeaponNode && input.punchAmount > options.punchDirectionThreshold && input.hitSpeed > options.punchSpeedThreshold) {
+			type = HitType::Punch;
+		}
+	}
+
+	if (type == HitType::None && input.hitSpeed > options.swingSpeedThreshold) {
+		type = HitType::Swing;
+	}
+
+	// Thresholding on some (small) roomspace hand velocity helps prevent hits while moving around / turning
+	bool isDisabled = input.handSpeedRoomspace < options.requiredHandSpeedRoomspace || (!input.isWeaponDrawn && options.disableHitIfSheathed);
+
+	return { type, isDisabled };
+}
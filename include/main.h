@@ -13,18 +13,37 @@ enum class RagdollState : UInt8
 	BlendOut,
 };
 
+// How much simulation an active ragdoll gets, from most to least expensive. See Config::RagdollLodOptions.
+enum class RagdollLod : UInt8
+{
+	Full,
+	RigidBody,
+	Keyframed,
+};
+
 struct ActiveRagdoll
 {
 	Blender blender{};
-	std::vector<hkQsTransform> animPose{};
-	std::vector<hkQsTransform> ragdollPose{};
-	std::vector<float> stress{};
+	PoseBuffer<hkQsTransform> animPose{};
+	PoseBuffer<hkQsTransform> ragdollPose{};
+	// The poses from the frame before, for the velocity of the source pose when an inertialized blend starts
+	PoseBuffer<hkQsTransform> previousAnimPose{};
+	PoseBuffer<hkQsTransform> previousRagdollPose{};
+	PoseBuffer<float> stress{};
+	void *poseSlab = nullptr; // owns the memory of all the pose buffers, see PoseBufferPool
+	int poseSlabNumPoses = 0;
+	int poseSlabNumBones = 0;
 	hkQsTransform hipBoneTransform{};
 	float avgStress = 0.f;
 	float deltaTime = 0.f;
+	double animPoseTime = 0.0;
+	double previousAnimPoseTime = 0.0;
+	double ragdollPoseTime = 0.0;
+	double previousRagdollPoseTime = 0.0;
 	RE::hkRefPtr<hkpEaseConstraintsAction> easeConstraintsAction = nullptr;
 	double stateChangedTime = 0.0;
 	RagdollState state = RagdollState::Idle;
+	RagdollLod lod = RagdollLod::Full;
 	KnockState knockState = KnockState::Normal;
 	bool isOn = false;
 	bool hasHipBoneTransform = false;
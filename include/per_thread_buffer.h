@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+
+// Append-only storage for events raised from havok's simulation threads.
+// Each thread claims a fixed-capacity buffer of its own the first time it appends, so appending normally takes no lock.
+// When a thread's buffer is full, or there are more threads than buffers, items spill into a shared overflow vector behind a mutex.
+// Drain() and Clear() must only be called while nothing can be appending, e.g. from a post-simulation callback; the simulation's end-of-step sync
+// is what makes the other threads' writes visible there.
+template <typename T, int NumBuffers = 16, int Capacity = 256>
+struct PerThreadBuffer
+{
+	PerThreadBuffer() : id(NextId()) {}
+	PerThreadBuffer(const PerThreadBuffer &) = delete;
+	PerThreadBuffer & operator=(const PerThreadBuffer &) = delete;
+
+	void Append(const T &item)
+	{
+		Buffer *buffer = GetThreadBuffer();
+		if (buffer && buffer->size < Capacity) {
+			buffer->items[buffer->size++] = item;
+			return;
+		}
+
+		std::scoped_lock lock(overflowLock);
+		overflow.push_back(item);
+	}
+
+	// Appends everything collected so far to out and empties the buffers. The order between threads is arbitrary, so sort the result if it matters.
+	void Drain(std::vector<T> &out)
+	{
+		int numBuffers = std::min(numClaimed.load(std::memory_order_acquire), NumBuffers);
+		for (int i = 0; i < numBuffers; i++) {
+			Buffer &buffer = buffers[i];
+			out.insert(out.end(), buffer.items.begin(), buffer.items.begin() + buffer.size);
+			buffer.size = 0;
+		}
+
+		out.insert(out.end(), overflow.begin(), overflow.end());
+		overflow.clear();
+	}
+
+	void Clear()
+	{
+		int numBuffers = std::min(numClaimed.load(std::memory_order_acquire), NumBuffers);
+		for (int i = 0; i < numBuffers; i++) {
+			buffers[i].size = 0;
+		}
+		overflow.clear();
+
+		// Make every thread claim a buffer again
+		numClaimed.store(0, std::memory_order_release);
+		id = NextId();
+	}
+
+private:
+	struct alignas(64) Buffer // a cache line apart so that threads don't contend over the sizes
+	{
+		std::array<T, Capacity> items{};
+		int size = 0;
+	};
+
+	struct ThreadSlot
+	{
+		UInt64 ownerId = 0;
+		int index = -1;
+	};
+
+	static UInt64 NextId()
+	{
+		static std::atomic<UInt64> nextId = 1;
+		return nextId.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	Buffer * GetThreadBuffer()
+	{
+		// Remembers the buffer for the last PerThreadBuffer this thread used. There is normally only one per item type, but if not, a thread just claims another buffer.
+		thread_local ThreadSlot slot{};
+		if (slot.ownerId != id) {
+			slot.ownerId = id;
+			int index = numClaimed.fetch_add(1, std::memory_order_acq_rel);
+			slot.index = index < NumBuffers ? index : -1;
+		}
+		return slot.index >= 0 ? &buffers[slot.index] : nullptr;
+	}
+
+	std::array<Buffer, NumBuffers> buffers{};
+	std::atomic<int> numClaimed = 0;
+	UInt64 id;
+
+	std::vector<T> overflow{};
+	std::mutex overflowLock{};
+};
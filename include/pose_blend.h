@@ -0,0 +1,26 @@
+#pragma once
+
+#include <Common/Base/hkBase.h>
+
+
+// Vectorized pose blending.
+// Poses are transposed in registers into a structure-of-arrays layout (xxxx, yyyy, zzzz, wwww) and blended 4 (SSE) or 8 (AVX2) bones at a time.
+// Translation and scale are lerped, rotation is nlerped with sign correction, which matches hkQsTransform::setInterpolate4().
+// The kernel is picked once at startup based on the cpu features; the portable kernel handles the leftover bones and cpus without SSE.
+
+enum class PoseBlendKernel : UInt8
+{
+	Portable,
+	SSE,
+	AVX2,
+};
+
+PoseBlendKernel GetPoseBlendKernel();
+const char * GetPoseBlendKernelName(PoseBlendKernel kernel);
+
+// out may alias src or dst
+void BlendPoses(const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, const float *weights, int numPoses);
+void BlendPoses(const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, float weight, int numPoses);
+
+// Explicit kernel selection, mostly for comparing kernels against each other
+void BlendPoses(PoseBlendKernel kernel, const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, const float *weights, float weight, int numPoses);
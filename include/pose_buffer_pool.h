@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+
+// Fixed-capacity view over pooled memory, with the subset of the std::vector interface the ragdoll code uses.
+// It never allocates: writes past the capacity are dropped. Copying would alias the memory, so it is move-only.
+template <typename T>
+struct PoseBuffer
+{
+	PoseBuffer() = default;
+	PoseBuffer(const PoseBuffer &) = delete;
+	PoseBuffer & operator=(const PoseBuffer &) = delete;
+	PoseBuffer(PoseBuffer &&other) { *this = std::move(other); }
+	PoseBuffer & operator=(PoseBuffer &&other)
+	{
+		ptr = other.ptr; count = other.count; maxCount = other.maxCount;
+		other.Reset(nullptr, 0);
+		return *this;
+	}
+
+	inline void Reset(T *memory, int capacity) { ptr = memory; count = 0; maxCount = capacity; }
+
+	inline T * data() { return ptr; }
+	inline const T * data() const { return ptr; }
+	inline int size() const { return count; }
+	inline int capacity() const { return maxCount; }
+	inline bool empty() const { return count == 0; }
+	inline T & operator[](int i) { return ptr[i]; }
+	inline const T & operator[](int i) const { return ptr[i]; }
+	inline T * begin() { return ptr; }
+	inline T * end() { return ptr + count; }
+
+	inline void assign(const T *first, const T *last)
+	{
+		count = std::min((int)(last - first), maxCount);
+		if (ptr != first) {
+			memcpy(ptr, first, count * sizeof(T));
+		}
+	}
+	inline void assign(const PoseBuffer &other) { assign(other.data(), other.data() + other.size()); }
+	inline void resize(int newCount) { count = std::clamp(newCount, 0, maxCount); }
+	inline void clear() { count = 0; }
+	inline void push_back(const T &value) { if (count < maxCount) ptr[count++] = value; }
+
+private:
+	T *ptr = nullptr;
+	int count = 0;
+	int maxCount = 0;
+};
+
+// Hands out one 16-byte aligned slab per active ragdoll holding all of its pose buffers, sized from its skeleton when it is activated.
+// Slabs are keyed by pose and bone count and go back to a free list when the ragdoll is deactivated, so reactivating actors with the same skeletons doesn't allocate.
+struct PoseBufferPool
+{
+	~PoseBufferPool();
+
+	bool Acquire(struct ActiveRagdoll &ragdoll, int numPoses, int numBones);
+	void Release(struct ActiveRagdoll &ragdoll);
+
+	// Frees all slabs on the free lists
+	void Trim();
+
+private:
+	static inline UInt64 GetKey(int numPoses, int numBones) { return (UInt64(numPoses) << 32) | UInt32(numBones); }
+	static size_t GetSlabSize(int numPoses, int numBones);
+
+	std::unordered_map<UInt64, std::vector<void *>> freeSlabs{};
+};
+
+extern PoseBufferPool g_poseBufferPool;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+
+#include <Physics/Dynamics/Entity/hkpRigidBody.h>
+
+#include "skse64/NiTypes.h"
+
+#include "flat_hash_map.h"
+
+
+// Impulses queued during the frame (mostly by hits), to be applied right before the physics step so that driveToPose() can't overwrite them.
+// Impulses are summed per body as they are queued, so a body that a hit reaches through several paths, or that several contacts hit in the same step,
+// gets one activation and one combined impulse. A point impulse J at p contributes J to the linear part and (p - com) x J to the angular part;
+// since the center of mass is only read when the impulses are applied, the angular part is kept as the sum of p x J and corrected by com x (sum of J) then.
+// Bodies are not referenced while queued, so each body is checked to still be part of its refr before it is touched. For that, the scene graph of each refr
+// is walked once per step, the first time one of its bodies comes up, and the bodies found are indexed. Nothing is kept past the step, so a 3d reload
+// or a world change can't leave stale bodies in the index.
+struct PrePhysicsJobs
+{
+	void QueuePointImpulse(hkpRigidBody *rigidBody, const NiPoint3 &point, const NiPoint3 &impulse, UInt32 refrHandle);
+
+	inline void QueueLinearImpulse(hkpRigidBody *rigidBody, const NiPoint3 &impulse, UInt32 refrHandle)
+	{
+		GetBodyImpulse(rigidBody, refrHandle).linearImpulse += impulse;
+	}
+
+	inline bool empty() const { return bodyImpulses.empty(); }
+
+	// Applies and then clears all the queued impulses. Must be called between driveToPose() and the physics step.
+	void Run();
+
+	void Clear();
+
+private:
+	struct BodyImpulse
+	{
+		hkpRigidBody *rigidBody;
+		UInt32 refrHandle;
+		NiPoint3 linearImpulse;
+		NiPoint3 pointImpulse; // sum of the point impulses
+		NiPoint3 pointMoment; // sum of point x impulse of the point impulses
+		bool hasPointImpulse;
+	};
+
+	inline BodyImpulse & GetBodyImpulse(hkpRigidBody *rigidBody, UInt32 refrHandle)
+	{
+		if (int *index = bodyIndices.find(rigidBody)) {
+			return bodyImpulses[*index];
+		}
+		bodyIndices[rigidBody] = (int)bodyImpulses.size();
+		return bodyImpulses.emplace_back(BodyImpulse{ rigidBody, refrHandle, NiPoint3(), NiPoint3(), NiPoint3(), false });
+	}
+
+	bool IsBodyValid(hkpRigidBody *rigidBody, UInt32 refrHandle);
+
+	std::vector<BodyImpulse> bodyImpulses{}; // in the order the bodies were first queued
+	FlatHashMap<hkpRigidBody *, int> bodyIndices{};
+
+	FlatHashSet<UInt32> indexedRefrs{}; // refr handles whose bodies are in bodyRefrs
+	FlatHashMap<hkpRigidBody *, UInt32> bodyRefrs{}; // body -> handle of the refr it was found in
+};
+
+extern PrePhysicsJobs g_prePhysicsJobs;
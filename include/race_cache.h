@@ -0,0 +1,44 @@
+#pragma once
+
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "skse64/GameForms.h"
+
+
+// Everything we derive from a race, computed once per race and stored as a bitmask so that per-frame race checks are a single lookup with no string comparisons.
+// The cache is dropped when the config options are reread or game data is (re)loaded.
+namespace RaceFlags {
+	enum : UInt32
+	{
+		Valid = 1 << 0,
+		Excluded = 1 << 1, // excludeRaces
+		SelfCollidable = 1 << 2, // NPC race with doBipedSelfCollisionForNPCs, or additionalSelfCollisionRaces
+		AggressionExcluded = 1 << 3, // aggressionExcludeRaces
+		NPC = 1 << 4, // has the ActorTypeNPC keyword
+
+		SizeShift = 8, // race size class (race->data.unk40) lives in the bits above this: 0 small, 1 medium, 2 large, 3 extra large
+	};
+}
+
+struct RaceCache
+{
+	UInt32 GetFlags(TESRace *race);
+
+	// Drops the cache if the config options have changed since it was filled. Main thread only.
+	void Validate();
+	void Clear();
+
+private:
+	static UInt32 ComputeFlags(TESRace *race);
+
+	std::unordered_map<TESRace *, UInt32> flags{};
+	std::shared_mutex lock{};
+	UInt32 optionsVersion = 0;
+};
+
+extern RaceCache g_raceCache;
+
+// 0 for a null race
+inline UInt32 GetRaceFlags(TESRace *race) { return race ? g_raceCache.GetFlags(race) : 0; }
+inline UInt32 GetRaceSize(UInt32 raceFlags) { return raceFlags >> RaceFlags::SizeShift; }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "skse64/GameReferences.h"
+
+
+// Caps how many actors get an active ragdoll at once, and optionally how much time the plugin spends on them per frame.
+// Every frame, actors in range are added as candidates, and Resolve() ranks them to decide which ones get a slot on the next frame.
+// Candidates are ranked by whether the player is interacting with them (or did so recently), then by distance.
+// Promotions and demotions have cooldowns so that actors near the cutoff don't thrash between active and inactive.
+// With neither limit set (the default), every actor is allowed right away and the ranking has no effect.
+struct RagdollBudget
+{
+	void AddCandidate(Actor *actor, float distance, bool isInteracting, bool isActive);
+
+	// For an active actor that can't be a candidate this frame (e.g. its ragdoll can't be added to the world right now),
+	// so that it keeps its slot until its ragdoll is actually removed
+	void KeepActive(Actor *actor);
+
+	void Resolve(double now);
+
+	bool IsAllowed(Actor *actor) const;
+
+	// Time spent in the ragdoll hooks, measured by the caller and accumulated over the frame
+	inline void AddCost(double seconds) { frameCost += seconds; }
+
+	void Clear();
+
+private:
+	struct Record
+	{
+		double lastInteractionTime = -1.0;
+		double allowedChangedTime = -1.0;
+		bool isAllowed = false;
+		bool isCandidate = false;
+		bool isKeptActive = false;
+	};
+
+	struct Candidate
+	{
+		Actor *actor;
+		float distance;
+		bool isInteracting;
+		bool isActive;
+		UInt8 tier; // lower is better, see Resolve()
+		float score; // lower is better, breaks ties within a tier
+	};
+
+	static bool IsLimited();
+	int GetMaxAllowed(int numActive);
+
+	std::unordered_map<Actor *, Record> records{};
+	std::vector<Candidate> candidates{};
+	double frameCost = 0.0;
+	double avgCostPerRagdoll = 0.0;
+};
+
+extern RagdollBudget g_ragdollBudget;
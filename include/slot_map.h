@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+// Contiguous storage with stable, generation-checked handles.
+// Values are kept densely packed so iterating is a linear scan. Removing swaps the last value into the hole, so raw pointers to values are only valid until the next Insert/Remove, while handles stay valid until their value is removed.
+template <typename T>
+struct SlotMap
+{
+	struct Handle
+	{
+		UInt32 index = UINT32_MAX;
+		UInt32 generation = 0;
+
+		inline bool operator==(const Handle &other) const { return index == other.index && generation == other.generation; }
+		inline bool operator!=(const Handle &other) const { return !(*this == other); }
+	};
+
+	Handle Insert(T &&value)
+	{
+		UInt32 slotIndex;
+		if (!freeSlots.empty()) {
+			slotIndex = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			slotIndex = (UInt32)slots.size();
+			slots.push_back({});
+		}
+
+		Slot &slot = slots[slotIndex];
+		slot.denseIndex = (UInt32)values.size();
+		values.push_back(std::move(value));
+		denseToSlot.push_back(slotIndex);
+
+		return { slotIndex, slot.generation };
+	}
+
+	inline T * Get(Handle handle)
+	{
+		if (handle.index >= slots.size()) return nullptr;
+		const Slot &slot = slots[handle.index];
+		if (slot.generation != handle.generation || slot.denseIndex == UINT32_MAX) return nullptr;
+		return &values[slot.denseIndex];
+	}
+
+	bool Remove(Handle handle)
+	{
+		if (!Get(handle)) return false;
+
+		Slot &slot = slots[handle.index];
+		UInt32 denseIndex = slot.denseIndex;
+		UInt32 lastIndex = (UInt32)values.size() - 1;
+		if (denseIndex != lastIndex) {
+			values[denseIndex] = std::move(values[lastIndex]);
+			denseToSlot[denseIndex] = denseToSlot[lastIndex];
+			slots[denseToSlot[denseIndex]].denseIndex = denseIndex;
+		}
+		values.pop_back();
+		denseToSlot.pop_back();
+
+		slot.denseIndex = UINT32_MAX;
+		++slot.generation; // invalidate outstanding handles
+		freeSlots.push_back(handle.index);
+		return true;
+	}
+
+	void Clear()
+	{
+		for (UInt32 slotIndex : denseToSlot) {
+			Slot &slot = slots[slotIndex];
+			slot.denseIndex = UINT32_MAX;
+			++slot.generation;
+			freeSlots.push_back(slotIndex);
+		}
+		values.clear();
+		denseToSlot.clear();
+	}
+
+	inline size_t Size() const { return values.size(); }
+	inline bool Empty() const { return values.empty(); }
+
+	inline typename std::vector<T>::iterator begin() { return values.begin(); }
+	inline typename std::vector<T>::iterator end() { return values.end(); }
+
+private:
+	struct Slot
+	{
+		UInt32 denseIndex = UINT32_MAX;
+		UInt32 generation = 0;
+	};
+
+	std::vector<Slot> slots{};
+	std::vector<UInt32> freeSlots{};
+	std::vector<T> values{};
+	std::vector<UInt32> denseToSlot{};
+};
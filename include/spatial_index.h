@@ -0,0 +1,42 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "skse64/GameReferences.h"
+#include "skse64/NiTypes.h"
+
+
+// Snapshot of the high process actors' positions and distances to the player, rebuilt once per frame from the main loop.
+// Positions are snapshotted when the index is built, so queries don't have to chase pointers into each TESObjectREFR.
+// All the queries are for given refs, so entries are looked up by refr; there are too few actors for a spatial grid to pay for its upkeep.
+// The index is only rebuilt on the main thread before the physics step, so the contact callbacks can read it without locking.
+struct SpatialIndex
+{
+	struct Entry
+	{
+		NiPoint3 pos;
+		Actor *actor;
+		UInt32 handle;
+		float distanceToPlayer; // game units
+	};
+
+	void Clear();
+	void Add(Actor *actor, UInt32 handle);
+	void Build(const NiPoint3 &playerPos);
+
+	const Entry * Find(TESObjectREFR *refr) const;
+
+	// Position as of the last build, or the current one for refs that aren't indexed
+	NiPoint3 GetPosition(TESObjectREFR *refr) const;
+
+	bool AreWithinDistance(TESObjectREFR *refrA, TESObjectREFR *refrB, float distance) const;
+
+	std::vector<Entry> entries{};
+	NiPoint3 playerPos{};
+
+private:
+	std::unordered_map<TESObjectREFR *, UInt32> refrToEntry{};
+};
+
+extern SpatialIndex g_spatialIndex;
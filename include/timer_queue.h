@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// Move-only void() callable that stores small callables (up to BufferSize bytes, e.g. a lambda capturing a few pointers and handles) inline,
+// so wrapping one doesn't allocate. Bigger ones still work, they just go on the heap.
+struct InlineJob
+{
+	static constexpr size_t BufferSize = 48;
+
+	InlineJob() = default;
+
+	template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineJob>>>
+	InlineJob(F &&f)
+	{
+		using T = std::decay_t<F>;
+		if constexpr (sizeof(T) <= BufferSize && alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<T>) {
+			new (buffer) T(std::forward<F>(f));
+			ops = &InlineOps<T>;
+		}
+		else {
+			*(T **)buffer = new T(std::forward<F>(f));
+			ops = &HeapOps<T>;
+		}
+	}
+
+	InlineJob(InlineJob &&other) noexcept { MoveFrom(other); }
+
+	InlineJob & operator=(InlineJob &&other) noexcept
+	{
+		if (this != &other) {
+			Reset();
+			MoveFrom(other);
+		}
+		return *this;
+	}
+
+	InlineJob(const InlineJob &) = delete;
+	InlineJob & operator=(const InlineJob &) = delete;
+
+	~InlineJob() { Reset(); }
+
+	inline explicit operator bool() const { return ops != nullptr; }
+	inline void operator()() { ops->invoke(buffer); }
+
+	void Reset()
+	{
+		if (ops) {
+			ops->destroy(buffer);
+			ops = nullptr;
+		}
+	}
+
+private:
+	struct Ops
+	{
+		void (*invoke)(void *storage);
+		void (*move)(void *to, void *from); // leaves from destroyed
+		void (*destroy)(void *storage);
+	};
+
+	template <typename T>
+	static constexpr Ops InlineOps{
+		[](void *storage) { (*(T *)storage)(); },
+		[](void *to, void *from) { new (to) T(std::move(*(T *)from)); ((T *)from)->~T(); },
+		[](void *storage) { ((T *)storage)->~T(); },
+	};
+
+	template <typename T>
+	static constexpr Ops HeapOps{
+		[](void *storage) { (**(T **)storage)(); },
+		[](void *to, void *from) { *(T **)to = *(T **)from; },
+		[](void *storage) { delete *(T **)storage; },
+	};
+
+	void MoveFrom(InlineJob &other)
+	{
+		if (other.ops) {
+			other.ops->move(buffer, other.buffer);
+			ops = other.ops;
+			other.ops = nullptr;
+		}
+	}
+
+	alignas(std::max_align_t) unsigned char buffer[BufferSize];
+	const Ops *ops = nullptr;
+};
+
+enum class TimerClock : UInt8
+{
+	Real, // g_currentFrameTime
+	Game, // g_currentScaledFrameTime, i.e. slows down with the global time multiplier
+};
+
+// Identifies a scheduled job for Cancel(). A token outlives its job harmlessly: once the job has run or been cancelled, its slot's generation moves on
+// and the token no longer matches anything.
+struct TimerToken
+{
+	UInt32 slot = 0;
+	UInt32 generation = 0; // 0 is never a live generation, so a default token is invalid
+};
+
+// Jobs to run once their time has come, one min-heap per clock ordered by run time, with ties broken by the order they were scheduled in.
+// Each Run() only touches the jobs that are due. Jobs live in reused slots, and cancelled jobs leave their heap node behind to be skipped when it comes up,
+// so once the slots and heaps have grown to their working size, scheduling doesn't allocate (as long as the job fits in an InlineJob).
+struct TimerQueue
+{
+	TimerToken Schedule(InlineJob job, double runTime, TimerClock clock = TimerClock::Real);
+
+	// Returns false if the job has already run or been cancelled
+	bool Cancel(TimerToken token);
+
+	bool IsPending(TimerToken token) const;
+
+	inline int size() const { return numPending; }
+	inline bool empty() const { return numPending == 0; }
+
+	// Runs the due jobs of the real clock, then those of the game clock. Jobs scheduled by a running job wait for the next Run(), even if they are already due.
+	void Run(double realTime, double gameTime);
+
+	void Clear();
+
+private:
+	struct Node
+	{
+		double runTime;
+		UInt64 sequence;
+		UInt32 slot;
+		UInt32 generation;
+	};
+
+	struct HeapOrder
+	{
+		// std heap functions build a max-heap, so the comparison is reversed to put the earliest job in front
+		inline bool operator()(const Node &a, const Node &b) const
+		{
+			return a.runTime != b.runTime ? a.runTime > b.runTime : a.sequence > b.sequence;
+		}
+	};
+
+	struct Slot
+	{
+		InlineJob job{};
+		UInt32 generation = 1;
+		bool isPending = false;
+	};
+
+	void PopDue(std::vector<Node> &heap, double now);
+	void Release(UInt32 slot);
+
+	std::vector<Node> heaps[2]{}; // by TimerClock
+	std::vector<Slot> slots{};
+	std::vector<UInt32> freeSlots{};
+	std::vector<Node> due{}; // scratch for Run()
+	UInt64 nextSequence = 0;
+	int numPending = 0;
+};
+
+extern TimerQueue g_timerQueue;
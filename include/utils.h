@@ -16,6 +16,7 @@
 
 extern ITimer g_timer;
 extern double g_currentFrameTime;
+extern double g_currentScaledFrameTime; // advances at *g_globalTimeMultiplier times the rate of g_currentFrameTime, for timers that slow down with the game
 //extern double g_deltaTime;
 
 inline void set_vtbl(void *object, void *vtbl) { *((void **)object) = ((void *)(vtbl)); }
@@ -85,7 +86,7 @@ inline bool CanWeaponStab(TESObjectWEAP *weapon) {
 bhkCollisionObject * GetCollisionObject(NiAVObject *obj);
 NiPointer<bhkRigidBody> GetRigidBody(NiAVObject *obj);
 NiPointer<bhkRigidBody> GetFirstRigidBody(NiAVObject *root);
-bool FindRigidBody(NiAVObject *root, hkpRigidBody *query);
+void ForEachRigidBody(NiAVObject *root, std::function<void(hkpRigidBody *)> f);
 void ForEachRagdollDriver(Actor *actor, std::function<void(hkbRagdollDriver *)> f);
 void ForEachAdjacentBody(hkbRagdollDriver *driver, hkpRigidBody *body, std::function<void(hkpRigidBody *)> f);
 bool DoesNodeHaveConstraint(NiNode *rootNode, NiAVObject *node);
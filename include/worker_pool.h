@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+
+// Small fixed pool of worker threads for splitting per-frame work. The calling thread participates in the work as well.
+// The destructor stops and joins the workers. A pool that lives until the process exits should be leaked instead of being a plain global,
+// since static destructors in a dll run under the loader lock, where joining a thread can deadlock. The os ends the threads at exit anyway.
+struct WorkerPool
+{
+	~WorkerPool();
+
+	void Start(int numWorkers);
+	void Stop();
+
+	// Runs func(i) for every i in [0, count) and returns once all of them are done
+	void ParallelFor(int count, const std::function<void(int)> &func);
+
+	inline int GetNumWorkers() const { return (int)threads.size(); }
+
+private:
+	void WorkerLoop(UInt64 lastGeneration);
+	void RunTasks();
+
+	std::vector<std::thread> threads{};
+	std::mutex lock{};
+	std::condition_variable workAvailable{};
+	std::condition_variable workDone{};
+	const std::function<void(int)> *task = nullptr;
+	std::atomic<int> nextIndex = 0;
+	int taskCount = 0;
+	int numFinishedWorkers = 0;
+	UInt64 generation = 0;
+	bool stopping = false;
+};
@@ -0,0 +1,93 @@
+#include "actor_state_tracker.h"
+#include "RE/havok_behavior.h"
+#include "utils.h"
+#include "config.h"
+
+
+ActorStateTracker g_actorStateTracker;
+
+void ActorStateTracker::BeginFrame(const std::vector<SpatialIndex::Entry> &entries)
+{
+	frameStates.clear();
+	for (const SpatialIndex::Entry &entry : entries) {
+		State &state = states[entry.actor];
+		if (state.handle != entry.handle) {
+			// New actor, or a different actor reusing the memory of one that's gone
+			state = State{};
+			state.handle = entry.handle;
+		}
+		state.isPresent = true;
+		frameStates.push_back(&state);
+	}
+
+	for (auto it = states.begin(); it != states.end();) {
+		if (!it->second.isPresent) {
+			it = states.erase(it);
+		}
+		else {
+			it->second.isPresent = false;
+			++it;
+		}
+	}
+}
+
+bool ActorStateTracker::NeedsRefresh(State &state, Actor *actor, UInt8 rangeZone, double now) const
+{
+	bool needsRefresh = state.isDirty || now - state.refreshTime >= Config::options.actorStateAuditInterval;
+
+	if (rangeZone != state.rangeZone) {
+		state.rangeZone = rangeZone;
+		needsRefresh = true;
+	}
+
+	if (TESObjectCELL *cell = actor->parentCell; cell != state.cell) {
+		state.cell = cell;
+		needsRefresh = true;
+	}
+
+	if (NiNode *root = actor->GetNiNode(); root != state.root) {
+		state.root = root;
+		needsRefresh = true;
+	}
+
+	if (KnockState knockState = GetActorKnockState(actor); knockState != state.knockState) {
+		state.knockState = knockState;
+		needsRefresh = true;
+	}
+
+	// The graphs array is read without holding the manager's lock. That's fine since this only compares it against the last value, and a torn read just causes a refresh.
+	void *graphManager = nullptr;
+	void *graphs = nullptr;
+	UInt32 numGraphs = 0;
+	BSTSmartPointer<BSAnimationGraphManager> animGraphManager{ 0 };
+	if (GetAnimationGraphManager(actor, animGraphManager)) {
+		graphManager = animGraphManager.ptr;
+		graphs = animGraphManager.ptr->graphs.GetData();
+		numGraphs = animGraphManager.ptr->graphs.size;
+	}
+	if (graphManager != state.graphManager || graphs != state.graphs || numGraphs != state.numGraphs) {
+		state.graphManager = graphManager;
+		state.graphs = graphs;
+		state.numGraphs = numGraphs;
+		needsRefresh = true;
+	}
+
+	if (needsRefresh) {
+		state.isDirty = false;
+		state.refreshTime = now;
+	}
+	return needsRefresh;
+}
+
+void ActorStateTracker::Invalidate(Actor *actor)
+{
+	if (auto it = states.find(actor); it != states.end()) {
+		it->second.isDirty = true;
+	}
+}
+
+void ActorStateTracker::Clear()
+{
+	states.clear();
+	frameStates.clear();
+}
@@ -0,0 +1,31 @@
+#include <cctype>
+
+#include "blend_curve.h"
+
+
+static const char *g_blendCurveNames[] = {
+	"linear",
+	"power",
+	"smoothstep",
+	"exponential",
+	"spring",
+};
+static_assert(sizeof(g_blendCurveNames) / sizeof(g_blendCurveNames[0]) == (size_t)BlendCurve::Type::Count);
+
+bool GetBlendCurveTypeFromName(std::string_view name, BlendCurve::Type &type)
+{
+	for (size_t i = 0; i < (size_t)BlendCurve::Type::Count; i++) {
+		std::string_view curveName = g_blendCurveNames[i];
+		if (name.size() == curveName.size() && std::equal(name.begin(), name.end(), curveName.begin(), [](char a, char b) { return tolower(a) == b; })) {
+			type = (BlendCurve::Type)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char * GetBlendCurveName(BlendCurve::Type type)
+{
+	if ((size_t)type >= (size_t)BlendCurve::Type::Count) return "unknown";
+	return g_blendCurveNames[(size_t)type];
+}
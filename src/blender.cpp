@@ -3,42 +3,269 @@
 #include "RE/offsets.h"
 
 
-Blender::Curve::Curve(double duration) : duration(duration) {};
+void Blender::StartBlend(BlendType blendType, double currentTime, const BlendCurve &blendCurve)
+{
+	resumeFrom = ResumeFrom::Nothing;
 
-float Blender::Curve::GetBlendValueAtTime(double time)
+	if (isActive) {
+		// We were already blending before, so the new blend needs to start from the current blend pose
+		if (IsInertialized(type)) {
+			// Inertialization doesn't keep the blended pose around, so it is rebuilt from the offsets on the first frame of the new blend
+			resumeFrom = ResumeFrom::Offsets;
+			previousStartTime = startTime;
+			previousDuration = curve.duration;
+			previousType = type;
+			isFirstBlendFrame = true;
+		}
+		else if (IsInertialized(blendType)) {
+			resumeFrom = ResumeFrom::CurrentPose;
+			isFirstBlendFrame = true;
+		}
+		else {
+			initialPose.assign(currentPose);
+			isFirstBlendFrame = false;
+		}
+	}
+	else {
+		isFirstBlendFrame = true;
+	}
+
+	startTime = currentTime;
+	type = blendType;
+	curve = blendCurve;
+	isActive = true;
+}
+
+// Quaternions here are x, y, z, w
+static inline void QuaternionMultiply(const float *a, const float *b, float *out)
 {
-	// Linear by default
-	// y = (1/d)*t
-	return std::clamp(time / duration, 0.0, 1.0);
+	float x = a[3] * b[0] + b[3] * a[0] + a[1] * b[2] - a[2] * b[1];
+	float y = a[3] * b[1] + b[3] * a[1] + a[2] * b[0] - a[0] * b[2];
+	float z = a[3] * b[2] + b[3] * a[2] + a[0] * b[1] - a[1] * b[0];
+	float w = a[3] * b[3] - (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]);
+	out[0] = x; out[1] = y; out[2] = z; out[3] = w;
 }
 
-Blender::PowerCurve::PowerCurve(double duration, double power) :
-	a(pow(power, -duration)), // a = b^(-d)
-	b(power),
-	Curve(duration)
-{}
+// Axis * angle
+static inline void QuaternionToRotationVector(const float *q, float *out)
+{
+	float sinHalfAngle = sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2]);
+	if (sinHalfAngle < 1e-6f) {
+		out[0] = out[1] = out[2] = 0.f;
+		return;
+	}
+	float scale = 2.f * atan2f(sinHalfAngle, q[3]) / sinHalfAngle;
+	out[0] = q[0] * scale; out[1] = q[1] * scale; out[2] = q[2] * scale;
+}
 
-float Blender::PowerCurve::GetBlendValueAtTime(double time)
+static inline float Dot3(const float *a, const float *b)
 {
-	// y = a * t^b
-	return std::clamp(a * pow(time, b), 0.0, 1.0);
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
 }
 
-void Blender::StartBlend(BlendType blendType, double currentTime, const Curve &blendCurve)
+// Quintic decay of an offset normalized to 1, from Bollo's "Inertialization: High-Performance Animation Transitions in Gears of War".
+// Reaches 0 at t1 with zero velocity and acceleration, starting with the given relative velocity.
+static float DecayOffset(float t, float t1, float v0, float &velocity)
 {
-	if (isActive) {
-		// We were already blending before, so set the initial pose to the current blend pose
-		initialPose = currentPose;
-		isFirstBlendFrame = false;
+	if (v0 > 0.f) v0 = 0.f; // don't move away from the target first
+	if (v0 < 0.f) t1 = std::min(t1, -5.f / v0); // avoid overshooting the target
+
+	if (t1 <= 0.f || t >= t1) {
+		velocity = 0.f;
+		return 0.f;
+	}
+
+	float t1_2 = t1 * t1;
+	float a0 = std::max(0.f, (-8.f * v0 * t1 - 20.f) / t1_2);
+	float A = -(a0 * t1_2 + 6.f * v0 * t1 + 12.f) / (2.f * t1_2 * t1_2 * t1);
+	float B = (3.f * a0 * t1_2 + 16.f * v0 * t1 + 30.f) / (2.f * t1_2 * t1_2);
+	float C = -(3.f * a0 * t1_2 + 12.f * v0 * t1 + 20.f) / (2.f * t1_2 * t1);
+
+	float t2 = t * t;
+	float t3 = t2 * t;
+	velocity = 5.f * A * t2 * t2 + 4.f * B * t3 + 3.f * C * t2 + a0 * t + v0;
+	return A * t3 * t2 + B * t2 * t2 + C * t3 + 0.5f * a0 * t2 + v0 * t + 1.f;
+}
+
+static void SetOffset(Blender::InertializationOffset &offset, const hkQsTransform &source, const hkQsTransform &target)
+{
+	const float *src = (const float *)&source;
+	const float *dst = (const float *)&target;
+
+	for (int i = 0; i < 4; i++) {
+		offset.translation[i] = src[i] - dst[i];
+		offset.scale[i] = src[8 + i] - dst[8 + i];
+	}
+
+	float inverseTarget[4] = { -dst[4], -dst[5], -dst[6], dst[7] };
+	QuaternionMultiply(src + 4, inverseTarget, offset.rotation);
+	if (offset.rotation[3] < 0.f) {
+		// Take the shortest path
+		for (int i = 0; i < 4; i++) {
+			offset.rotation[i] = -offset.rotation[i];
+		}
+	}
+
+	offset.translationVelocity = 0.f;
+	offset.rotationVelocity = 0.f;
+	offset.scaleVelocity = 0.f;
+}
+
+// Sets the offset velocities from where the source was the frame before, relative to the offset from the same target.
+// Only the part of the source's motion along the offset counts, as the offset only ever scales towards zero.
+static void SetOffsetVelocity(Blender::InertializationOffset &offset, const hkQsTransform &previousSource, const hkQsTransform &target, float deltaTime)
+{
+	Blender::InertializationOffset previous;
+	SetOffset(previous, previousSource, target);
+
+	float dotNew = Dot3(offset.translation, offset.translation);
+	if (dotNew > 1e-8f) {
+		offset.translationVelocity = (dotNew - Dot3(previous.translation, offset.translation)) / (dotNew * deltaTime);
+	}
+
+	dotNew = Dot3(offset.scale, offset.scale);
+	if (dotNew > 1e-8f) {
+		offset.scaleVelocity = (dotNew - Dot3(previous.scale, offset.scale)) / (dotNew * deltaTime);
+	}
+
+	float previousRotation[3], newRotation[3];
+	QuaternionToRotationVector(previous.rotation, previousRotation);
+	QuaternionToRotationVector(offset.rotation, newRotation);
+	dotNew = Dot3(newRotation, newRotation);
+	if (dotNew > 1e-8f) {
+		offset.rotationVelocity = (dotNew - Dot3(previousRotation, newRotation)) / (dotNew * deltaTime);
+	}
+}
+
+static void ApplyOffset(const Blender::InertializationOffset &offset, const hkQsTransform &target, hkQsTransform &out, float t, float t1, float *velocities = nullptr)
+{
+	float translationVelocity, rotationVelocity, scaleVelocity;
+	float translationAmount = DecayOffset(t, t1, offset.translationVelocity, translationVelocity);
+	float rotationAmount = DecayOffset(t, t1, offset.rotationVelocity, rotationVelocity);
+	float scaleAmount = DecayOffset(t, t1, offset.scaleVelocity, scaleVelocity);
+	if (velocities) {
+		velocities[0] = translationVelocity;
+		velocities[1] = rotationVelocity;
+		velocities[2] = scaleVelocity;
+	}
+
+	const float *dst = (const float *)&target;
+	float *o = (float *)&out;
+
+	// nlerp from identity to the rotation offset
+	float rotation[4];
+	for (int i = 0; i < 3; i++) {
+		rotation[i] = offset.rotation[i] * rotationAmount;
+	}
+	rotation[3] = 1.f + (offset.rotation[3] - 1.f) * rotationAmount;
+	float invLength = 1.f / sqrtf(rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+	for (int i = 0; i < 4; i++) {
+		rotation[i] *= invLength;
+	}
+
+	for (int i = 0; i < 4; i++) {
+		o[i] = dst[i] + offset.translation[i] * translationAmount;
+		o[8 + i] = dst[8 + i] + offset.scale[i] * scaleAmount;
+	}
+	QuaternionMultiply(rotation, dst + 4, o + 4);
+}
+
+// Re-targets an offset that is partway through decaying to a new target pose, carrying over its velocity
+static void ResumeOffset(Blender::InertializationOffset &offset, const hkQsTransform &previousTarget, const hkQsTransform &target, float t, float t1)
+{
+	float velocities[3];
+	hkQsTransform source;
+	ApplyOffset(offset, previousTarget, source, t, t1, velocities);
+
+	Blender::InertializationOffset previous = offset;
+	SetOffset(offset, source, target);
+
+	// Project the previous offset velocity onto the new offset direction
+	float dotNew = Dot3(offset.translation, offset.translation);
+	if (dotNew > 1e-8f) {
+		offset.translationVelocity = Dot3(previous.translation, offset.translation) * velocities[0] / dotNew;
+	}
+
+	dotNew = Dot3(offset.scale, offset.scale);
+	if (dotNew > 1e-8f) {
+		offset.scaleVelocity = Dot3(previous.scale, offset.scale) * velocities[2] / dotNew;
+	}
+
+	float previousRotation[3], newRotation[3];
+	QuaternionToRotationVector(previous.rotation, previousRotation);
+	QuaternionToRotationVector(offset.rotation, newRotation);
+	dotNew = Dot3(newRotation, newRotation);
+	if (dotNew > 1e-8f) {
+		offset.rotationVelocity = Dot3(previousRotation, newRotation) * velocities[1] / dotNew;
+	}
+}
+
+// Longest gap between two captured poses for them to still count as consecutive frames
+static constexpr float g_maxSourceVelocityDeltaTime = 0.1f;
+
+static inline const hkQsTransform * GetTargetPose(const ActiveRagdoll &ragdoll, Blender::BlendType blendType)
+{
+	return blendType == Blender::BlendType::InertializedAnimToRagdoll ? ragdoll.ragdollPose.data() : ragdoll.animPose.data();
+}
+
+void Blender::StartInertialization(const ActiveRagdoll &ragdoll, const hkQsTransform *targetPose, int numPoses, double frameTime)
+{
+	if (resumeFrom == ResumeFrom::Offsets && offsets.size() == numPoses) {
+		float elapsedTime = (frameTime - previousStartTime) * *g_globalTimeMultiplier;
+		const hkQsTransform *previousTarget = GetTargetPose(ragdoll, previousType);
+		for (int i = 0; i < numPoses; i++) {
+			ResumeOffset(offsets[i], previousTarget[i], targetPose[i], elapsedTime, previousDuration);
+		}
 	}
 	else {
-		isFirstBlendFrame = true;
+		const hkQsTransform *sourcePose;
+		const hkQsTransform *previousSourcePose = nullptr; // when known, so the offsets start out moving the way the source was
+		float deltaTime = 0.f;
+		if (resumeFrom == ResumeFrom::CurrentPose && currentPose.size() >= numPoses) {
+			// The blended pose from the frame before isn't kept, so this one starts from rest
+			sourcePose = currentPose.data();
+		}
+		else if (resumeFrom == ResumeFrom::Offsets) {
+			// Pose size changed under us, there is nothing sensible to blend from
+			sourcePose = targetPose;
+		}
+		else {
+			bool isFromAnim = type == BlendType::InertializedAnimToRagdoll;
+			sourcePose = isFromAnim ? ragdoll.animPose.data() : ragdoll.ragdollPose.data();
+
+			const PoseBuffer<hkQsTransform> &previousPose = isFromAnim ? ragdoll.previousAnimPose : ragdoll.previousRagdollPose;
+			double poseTime = isFromAnim ? ragdoll.animPoseTime : ragdoll.ragdollPoseTime;
+			double previousPoseTime = isFromAnim ? ragdoll.previousAnimPoseTime : ragdoll.previousRagdollPoseTime;
+			deltaTime = (poseTime - previousPoseTime) * *g_globalTimeMultiplier;
+			// A previous pose from longer ago is from before the ragdoll was last turned on, and says nothing about how the source is moving now
+			if (previousPose.size() >= numPoses && deltaTime > 0.f && deltaTime <= g_maxSourceVelocityDeltaTime) {
+				previousSourcePose = previousPose.data();
+			}
+		}
+
+		offsets.resize(numPoses);
+		for (int i = 0; i < numPoses; i++) {
+			SetOffset(offsets[i], sourcePose[i], targetPose[i]);
+			if (previousSourcePose) {
+				SetOffsetVelocity(offsets[i], previousSourcePose[i], targetPose[i], deltaTime);
+			}
+		}
 	}
 
-	startTime = currentTime;
-	type = blendType;
-	curve = blendCurve;
-	isActive = true;
+	resumeFrom = ResumeFrom::Nothing;
+}
+
+void Blender::ApplyPreviousInertialization(const ActiveRagdoll &ragdoll, hkQsTransform *poseOut, int numPoses, double frameTime)
+{
+	float elapsedTime = (frameTime - previousStartTime) * *g_globalTimeMultiplier;
+	const hkQsTransform *previousTarget = GetTargetPose(ragdoll, previousType);
+	int numOffsets = std::min(numPoses, (int)offsets.size());
+	for (int i = 0; i < numOffsets; i++) {
+		ApplyOffset(offsets[i], previousTarget[i], poseOut[i], elapsedTime, previousDuration);
+	}
+	for (int i = numOffsets; i < numPoses; i++) {
+		poseOut[i] = previousTarget[i];
+	}
 }
 
 bool Blender::Update(const ActiveRagdoll &ragdoll, const hkbRagdollDriver &driver, hkbGeneratorOutput &inOut, double frameTime)
@@ -51,38 +278,69 @@ bool Blender::Update(const ActiveRagdoll &ragdoll, const hkbRagdollDriver &drive
 
 	hkbGeneratorOutput::TrackHeader *poseHeader = GetTrackHeader(inOut, hkbGeneratorOutput::StandardTracks::TRACK_POSE);
 	if (poseHeader && poseHeader->m_onFraction > 0.f) {
-		int numPoses = poseHeader->m_numData;
+		// The pose buffers are sized from the skeleton when the ragdoll is activated, never go past them
+		int numPoses = std::min<int>(poseHeader->m_numData, initialPose.capacity());
 		hkQsTransform *poseOut = (hkQsTransform *)Track_getData(inOut, *poseHeader);
 
-		// Save initial pose if necessary
-		if ((type == BlendType::AnimToRagdoll || type == BlendType::RagdollToAnim || type == BlendType::RagdollToCurrentRagdoll) && isFirstBlendFrame) {
-			if (type == BlendType::AnimToRagdoll)
-				initialPose = ragdoll.animPose;
-			else if (type == BlendType::RagdollToAnim)
-				initialPose = ragdoll.ragdollPose;
-			else if (type == BlendType::RagdollToCurrentRagdoll)
-				initialPose = ragdoll.ragdollPose;
-		}
-		isFirstBlendFrame = false;
+		if (IsInertialized(type)) {
+			const hkQsTransform *targetPose = GetTargetPose(ragdoll, type);
+			if (isFirstBlendFrame) {
+				StartInertialization(ragdoll, targetPose, numPoses, frameTime);
+			}
+			isFirstBlendFrame = false;
 
-		// Blend poses
-		if (type == BlendType::AnimToRagdoll) {
-			hkbBlendPoses(numPoses, initialPose.data(), ragdoll.ragdollPose.data(), lerpAmount, poseOut);
-		}
-		else if (type == BlendType::RagdollToAnim) {
-			hkbBlendPoses(numPoses, initialPose.data(), ragdoll.animPose.data(), lerpAmount, poseOut);
-		}
-		else if (type == BlendType::CurrentAnimToRagdoll) {
-			hkbBlendPoses(numPoses, ragdoll.animPose.data(), ragdoll.ragdollPose.data(), lerpAmount, poseOut);
-		}
-		else if (type == BlendType::CurrentRagdollToAnim) {
-			hkbBlendPoses(numPoses, ragdoll.ragdollPose.data(), ragdoll.animPose.data(), lerpAmount, poseOut);
-		}
-		else if (type == BlendType::RagdollToCurrentRagdoll) {
-			hkbBlendPoses(numPoses, initialPose.data(), ragdoll.ragdollPose.data(), lerpAmount, poseOut);
+			// No need to save the blended pose, re-blending from here rebuilds it from the offsets
+			numPoses = std::min(numPoses, (int)offsets.size());
+			for (int i = 0; i < numPoses; i++) {
+				ApplyOffset(offsets[i], targetPose[i], poseOut[i], elapsedTime, curve.duration);
+			}
 		}
+		else {
+			// Save initial pose if necessary
+			if ((type == BlendType::AnimToRagdoll || type == BlendType::RagdollToAnim || type == BlendType::RagdollToCurrentRagdoll) && isFirstBlendFrame) {
+				if (resumeFrom == ResumeFrom::Offsets) {
+					initialPose.resize(numPoses);
+					ApplyPreviousInertialization(ragdoll, initialPose.data(), numPoses, frameTime);
+				}
+				else if (type == BlendType::AnimToRagdoll)
+					initialPose.assign(ragdoll.animPose);
+				else if (type == BlendType::RagdollToAnim)
+					initialPose.assign(ragdoll.ragdollPose);
+				else if (type == BlendType::RagdollToCurrentRagdoll)
+					initialPose.assign(ragdoll.ragdollPose);
+			}
+			isFirstBlendFrame = false;
+			resumeFrom = ResumeFrom::Nothing;
 
-		currentPose.assign(poseOut, poseOut + numPoses); // save the blended pose in case we need to blend out from here
+			// Blend poses
+			const hkQsTransform *srcPose = nullptr;
+			const hkQsTransform *dstPose = nullptr;
+			if (type == BlendType::AnimToRagdoll) {
+				srcPose = initialPose.data();
+				dstPose = ragdoll.ragdollPose.data();
+			}
+			else if (type == BlendType::RagdollToAnim) {
+				srcPose = initialPose.data();
+				dstPose = ragdoll.animPose.data();
+			}
+			else if (type == BlendType::CurrentAnimToRagdoll) {
+				srcPose = ragdoll.animPose.data();
+				dstPose = ragdoll.ragdollPose.data();
+			}
+			else if (type == BlendType::CurrentRagdollToAnim) {
+				srcPose = ragdoll.ragdollPose.data();
+				dstPose = ragdoll.animPose.data();
+			}
+			else if (type == BlendType::RagdollToCurrentRagdoll) {
+				srcPose = initialPose.data();
+				dstPose = ragdoll.ragdollPose.data();
+			}
+
+			if (srcPose && dstPose) {
+				BlendPoses(srcPose, dstPose, poseOut, lerpAmount, numPoses);
+				currentPose.assign(poseOut, poseOut + numPoses); // save the blended pose in case we need to blend out from here
+			}
+		}
 	}
 
 	if (elapsedTime >= curve.duration) {
@@ -92,10 +350,3 @@ bool Blender::Update(const ActiveRagdoll &ragdoll, const hkbRagdollDriver &drive
 
 	return false;
 }
-
-void BlendPoses(const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, float *weights, int numPoses)
-{
-	for (int i = 0; i < numPoses; i++) {
-		outPoses[i].setInterpolate4(srcPoses[i], dstPoses[i], weights[i]);
-	}
-}
@@ -0,0 +1,80 @@
+#include <mutex>
+
+#include "body_info_cache.h"
+#include "utils.h"
+#include "RE/havok.h"
+#include "RE/offsets.h"
+
+
+BodyInfoCache g_bodyInfoCache;
+
+extern bhkRigidBody *g_rightHand;
+extern bhkRigidBody *g_leftHand;
+extern bhkRigidBody *g_rightWeapon;
+extern bhkRigidBody *g_leftWeapon;
+extern bhkRigidBody *g_rightHeldObject;
+extern bhkRigidBody *g_leftHeldObject;
+extern UInt32 g_higgsCollisionLayer;
+
+BodyInfo BodyInfoCache::Compute(hkpRigidBody *body)
+{
+	BodyInfo info;
+
+	UInt32 filterInfo = body->m_collidable.m_broadPhaseHandle.m_collisionFilterInfo;
+
+	if (bhkRigidBody *wrapper = (bhkRigidBody *)body->m_userData) {
+		if (wrapper == g_leftHand || wrapper == g_rightHand) {
+			info.flags |= BodyFlags::Hand;
+		}
+		else if (wrapper == g_leftWeapon || wrapper == g_rightWeapon) {
+			info.flags |= BodyFlags::Weapon;
+		}
+		else if (wrapper == g_leftHeldObject || wrapper == g_rightHeldObject) {
+			info.flags |= BodyFlags::Held;
+		}
+
+		if (wrapper == g_leftHand || wrapper == g_leftWeapon || wrapper == g_leftHeldObject) {
+			info.flags |= BodyFlags::Left;
+		}
+
+		if (info.flags & (BodyFlags::Hand | BodyFlags::Weapon | BodyFlags::Held) && (filterInfo & 0x7f) == g_higgsCollisionLayer) {
+			info.flags |= BodyFlags::Higgs;
+		}
+	}
+
+	info.refr = GetRefFromCollidable(&body->m_collidable);
+	if (info.refr) {
+		info.actor = DYNAMIC_CAST(info.refr, TESObjectREFR, Actor);
+	}
+
+	if (info.actor) {
+		if (GetVehicleHandle(info.actor) != *g_invalidRefHandle) {
+			info.flags |= BodyFlags::InVehicle;
+		}
+	}
+
+	return info;
+}
+
+BodyInfo BodyInfoCache::Get(hkpRigidBody *body)
+{
+	{
+		std::shared_lock readLock(lock);
+		if (const BodyInfo *info = infos.find(body)) {
+			return *info;
+		}
+	}
+
+	BodyInfo info = Compute(body);
+	{
+		std::unique_lock writeLock(lock);
+		infos[body] = info;
+	}
+	return info;
+}
+
+void BodyInfoCache::Clear()
+{
+	std::unique_lock writeLock(lock);
+	infos.clear();
+}
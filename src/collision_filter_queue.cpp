@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "collision_filter_queue.h"
+#include "RE/havok.h"
+#include "RE/offsets.h"
+
+
+CollisionFilterUpdateQueue g_collisionFilterUpdateQueue;
+
+void CollisionFilterUpdateQueue::Queue(hkpRigidBody *body, hkpUpdateCollisionFilterOnEntityMode mode)
+{
+	hkpWorld *world = body->getWorld();
+	if (!world) return;
+
+	if (auto it = requestIndices.find(body); it != requestIndices.end()) {
+		Request &request = requests[it->second];
+		// A full check also drops collisions that are now filtered out, so it covers the cheaper mode
+		if (mode == HK_UPDATE_FILTER_ON_ENTITY_FULL_CHECK) {
+			request.mode = HK_UPDATE_FILTER_ON_ENTITY_FULL_CHECK;
+		}
+		return;
+	}
+
+	requestIndices[body] = (int)requests.size();
+	requests.push_back({ body, world, mode });
+}
+
+void CollisionFilterUpdateQueue::Flush()
+{
+	if (requests.empty()) return;
+
+	// Almost everything will be in the same world, but group by world just in case
+	std::stable_sort(requests.begin(), requests.end(), [](const Request &a, const Request &b) { return a.world < b.world; });
+
+	for (size_t start = 0; start < requests.size();) {
+		ahkpWorld *world = (ahkpWorld *)requests[start].world;
+		size_t end = start;
+		while (end < requests.size() && requests[end].world == world) end++;
+
+		if (bhkWorld *worldWrapper = world->m_userData) {
+			BSWriteLocker lock(&worldWrapper->worldLock);
+
+			for (size_t i = start; i < end; i++) {
+				const Request &request = requests[i];
+				if (request.body->getWorld() != world) continue; // removed from the world since it was queued
+
+				hkpWorld_UpdateCollisionFilterOnEntity(world, request.body, request.mode, HK_UPDATE_COLLECTION_FILTER_IGNORE_SHAPE_COLLECTIONS);
+			}
+		}
+
+		start = end;
+	}
+
+	Clear();
+}
+
+void CollisionFilterUpdateQueue::Clear()
+{
+	requests.clear();
+	requestIndices.clear();
+}
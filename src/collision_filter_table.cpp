@@ -0,0 +1,137 @@
+#include "collision_filter_table.h"
+#include "config.h"
+
+
+CollisionFilterTable g_collisionFilterTable;
+
+using Result = CollisionFilterTable::Result;
+using LayerClass = CollisionFilterTable::LayerClass;
+
+Result CollisionFilterTable::Evaluate(LayerClass classA, LayerClass classB, bool isSameGroup, UInt8 flagsA, UInt8 flagsB, const Options &options)
+{
+	if (classA == LayerClass::Biped && classB == LayerClass::Biped) {
+		// Biped vs. biped
+		if (isSameGroup) {
+			// biped self-collision
+			if (flagsA & GroupFlags::SelfCollidable) {
+				return Result::Continue; // will collide with all non-adjacent bones
+			}
+			else {
+				return Result::Ignore;
+			}
+		}
+		else {
+			// Biped vs. another biped
+			if (options.doBipedNonSelfCollision) {
+				return Result::Continue;
+			}
+			else {
+				return Result::Ignore;
+			}
+		}
+	}
+
+	if (classA != LayerClass::CharController && classB != LayerClass::CharController) {
+		// Neither collidee is a character controller
+		return Result::Continue;
+	}
+
+	if (classA == LayerClass::CharController && classB == LayerClass::CharController) {
+		// Both collidees are character controllers. If one of them is the player, ignore the collision.
+		if ((flagsA | flagsB) & GroupFlags::Player) {
+			UInt8 otherFlags = (flagsA & GroupFlags::Player) ? flagsB : flagsA;
+			if (otherFlags & GroupFlags::Hittable) {
+				// Still collide the player with hittable character controllers
+				return Result::Continue;
+			}
+			return Result::Ignore;
+		}
+		return Result::Continue;
+	}
+
+	// One of the collidees is a character controller
+
+	bool isCharControllerA = classA == LayerClass::CharController;
+	UInt8 flags = isCharControllerA ? flagsA : flagsB;
+	UInt8 otherFlags = isCharControllerA ? flagsB : flagsA;
+	LayerClass otherClass = isCharControllerA ? classB : classA;
+
+	if (!(flags & GroupFlags::Player)) {
+		// It's not the player
+
+		if ((otherFlags & GroupFlags::Player) && otherClass == LayerClass::Higgs) {
+			// Higgs vs. non-player character controller
+			if (flags & GroupFlags::Hittable) {
+				return Result::Collide;
+			}
+			else {
+				return Result::Ignore;
+			}
+		}
+
+		return Result::Continue;
+	}
+
+	// The character controller belongs to the player
+
+	if (!(otherFlags & GroupFlags::Player) && otherClass == LayerClass::Biped) {
+		// Collide with the biped unless we want to explicitly ignore them
+		if (!options.enablePlayerBipedCollision || (otherFlags & GroupFlags::Held)) {
+			return Result::Ignore;
+		}
+
+		if (!(otherFlags & GroupFlags::ActiveBiped)) {
+			// Disable collision with biped objects that are not actors
+			return Result::Ignore;
+		}
+
+		return Result::Collide;
+	}
+
+	return Result::Continue;
+}
+
+void CollisionFilterTable::Build(Table &table, UInt32 higgsLayer)
+{
+	for (UInt32 layer = 0; layer < 128; layer++) {
+		LayerClass layerClass = LayerClass::Other;
+		if (layer == BGSCollisionLayer::kCollisionLayer_Biped || layer == BGSCollisionLayer::kCollisionLayer_BipedNoCC) {
+			layerClass = LayerClass::Biped;
+		}
+		else if (layer == BGSCollisionLayer::kCollisionLayer_CharController) {
+			layerClass = LayerClass::CharController;
+		}
+		else if (layer == higgsLayer) {
+			layerClass = LayerClass::Higgs;
+		}
+		table.layerClasses[layer] = (UInt8)layerClass;
+	}
+
+	Options options{ Config::options.doBipedNonSelfCollision, Config::options.enablePlayerBipedCollision };
+
+	for (UInt8 classA = 0; classA < 4; classA++) {
+		for (UInt8 classB = 0; classB < 4; classB++) {
+			for (int isSameGroup = 0; isSameGroup < 2; isSameGroup++) {
+				for (UInt8 flagsA = 0; flagsA <= FlagsMask; flagsA++) {
+					for (UInt8 flagsB = 0; flagsB <= FlagsMask; flagsB++) {
+						Result result = Evaluate((LayerClass)classA, (LayerClass)classB, isSameGroup, flagsA, flagsB, options);
+						table.results[GetIndex(classA, classB, isSameGroup, flagsA, flagsB)] = (UInt8)result;
+					}
+				}
+			}
+		}
+	}
+}
+
+void CollisionFilterTable::Validate(UInt32 higgsLayer)
+{
+	if (isBuilt && optionsVersion == Config::optionsVersion && builtHiggsLayer == higgsLayer) return;
+
+	int next = 1 - current.load(std::memory_order_relaxed); // even for the first build, since the filter may already be reading the empty table
+	Build(tables[next], higgsLayer);
+	current.store(next, std::memory_order_release);
+
+	optionsVersion = Config::optionsVersion;
+	builtHiggsLayer = higgsLayer;
+	isBuilt = true;
+}
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cstring>
+
+#include "collision_group_flags.h"
+
+
+CollisionGroupFlags g_collisionGroupFlags;
+
+CollisionGroupFlags::CollisionGroupFlags() :
+	staging(std::make_unique<UInt8[]>(NumGroups)),
+	published{ std::make_unique<UInt8[]>(NumGroups), std::make_unique<UInt8[]>(NumGroups) }
+{
+}
+
+void CollisionGroupFlags::Assign(UInt8 flag, const UInt16 *groups, int numGroups)
+{
+	int bit = 0;
+	while (bit < 8 && !(flag & (1 << bit))) ++bit;
+	if (bit == 8) return;
+
+	std::vector<UInt16> &assigned = assignedGroups[bit];
+	if ((int)assigned.size() == numGroups && std::equal(assigned.begin(), assigned.end(), groups)) return;
+
+	for (UInt16 group : assigned) {
+		Remove(group, flag);
+	}
+	assigned.assign(groups, groups + numGroups);
+	for (UInt16 group : assigned) {
+		Add(group, flag);
+	}
+}
+
+void CollisionGroupFlags::Publish()
+{
+	if (!isDirty) return;
+
+	int next = 1 - current.load(std::memory_order_relaxed);
+	memcpy(published[next].get(), staging.get(), NumGroups);
+	current.store(next, std::memory_order_release);
+	isDirty = false;
+}
+
+void CollisionGroupFlags::Reset()
+{
+	memset(staging.get(), 0, NumGroups);
+	memset(published[0].get(), 0, NumGroups);
+	memset(published[1].get(), 0, NumGroups);
+	for (std::vector<UInt16> &assigned : assignedGroups) {
+		assigned.clear();
+	}
+	isDirty = false;
+}
@@ -20,6 +20,7 @@ static inline double vlibGetSetting(const char * name) {
 namespace Config {
 	// Define extern options
 	Options options;
+	UInt32 optionsVersion = 0;
 
 	bool ReadFloat(const std::string &name, float &val)
 	{
@@ -73,6 +74,19 @@ namespace Config {
 		return true;
 	}
 
+	bool ReadBlendCurve(const std::string &name, BlendCurve::Type &val)
+	{
+		std::string data;
+		if (!ReadString(name, data)) return false;
+
+		if (!GetBlendCurveTypeFromName(data, val)) {
+			_WARNING("Unknown blend curve for config option %s: %s", name.c_str(), data.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
 	bool ReadVector(const std::string &name, NiPoint3 &vec)
 	{
 		if (!ReadFloat(name + "X", vec.x)) return false;
@@ -111,12 +125,44 @@ namespace Config {
 		return true;
 	}
 
+	bool ReadRagdollLodOptions(const std::string &prefix, RagdollLodOptions &val)
+	{
+		if (!ReadFloat(prefix + "MaxDistance", val.maxDistance)) return false;
+		if (!ReadBool(prefix + "UsePoweredController", val.usePoweredController)) return false;
+		if (!ReadBool(prefix + "LoosenConstraints", val.loosenConstraints)) return false;
+		if (!ReadBool(prefix + "DisableGravity", val.disableGravity)) return false;
+		if (!ReadBool(prefix + "ReadStress", val.readStress)) return false;
+		if (!ReadBool(prefix + "Keyframed", val.keyframed)) return false;
+		return true;
+	}
+
 	bool ReadConfigOptions()
 	{
+		++optionsVersion;
+
 		if (!ReadFloat("activeRagdollStartDistance", options.activeRagdollStartDistance)) return false;
 		if (!ReadFloat("activeRagdollEndDistance", options.activeRagdollEndDistance)) return false;
 
+		if (!ReadRagdollLodOptions("lodFull", options.lodFull)) return false;
+		if (!ReadRagdollLodOptions("lodRigidBody", options.lodRigidBody)) return false;
+		if (!ReadRagdollLodOptions("lodKeyframed", options.lodKeyframed)) return false;
+		if (!ReadFloat("lodHysteresisDistance", options.lodHysteresisDistance)) return false;
+
+		if (!ReadBool("parallelActorGather", options.parallelActorGather)) return false;
+		if (!ReadInt("actorGatherWorkerThreads", options.actorGatherWorkerThreads)) return false;
+		if (!ReadDouble("actorStateAuditInterval", options.actorStateAuditInterval)) return false;
+
+		if (!ReadInt("maxActiveRagdolls", options.maxActiveRagdolls)) return false;
+		if (!ReadDouble("activeRagdollCostBudgetMicroseconds", options.activeRagdollCostBudgetMicroseconds)) return false;
+		if (!ReadDouble("budgetPromoteCooldown", options.budgetPromoteCooldown)) return false;
+		if (!ReadDouble("budgetDemoteCooldown", options.budgetDemoteCooldown)) return false;
+		if (!ReadDouble("budgetInteractionMemoryTime", options.budgetInteractionMemoryTime)) return false;
+		if (!ReadFloat("budgetHysteresisDistance", options.budgetHysteresisDistance)) return false;
+
 		if (!ReadDouble("blendInTime", options.blendInTime)) return false;
+		if (!ReadBlendCurve("blendInCurve", options.blendInCurve)) return false;
+		if (!ReadBlendCurve("getUpBlendCurve", options.getUpBlendCurve)) return false;
+		if (!ReadBool("inertializeBlendIn", options.inertializeBlendIn)) return false;
 
 		if (!ReadBool("enableKeyframes", options.enableKeyframes)) return false;
 		if (!ReadDouble("blendInKeyframeTime", options.blendInKeyframeTime)) return false;
@@ -125,6 +171,9 @@ namespace Config {
 		if (!ReadDouble("hitCooldownTimeFallback", options.hitCooldownTimeFallback)) return false;
 		if (!ReadDouble("physicsHitRecoveryTime", options.physicsHitRecoveryTime)) return false;
 
+		if (!ReadBool("recordContactEvents", options.recordContactEvents)) return false;
+		if (!ReadString("contactRecordingPath", options.contactRecordingPath)) return false;
+
 		if (!ReadDouble("thrownObjectLingerTime", options.thrownObjectLingerTime)) return false;
 
 		if (!ReadDouble("worldChangedWaitTime", options.worldChangedWaitTime)) return false;
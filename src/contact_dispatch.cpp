@@ -0,0 +1,70 @@
+#include "contact_dispatch.h"
+#include "config.h"
+
+
+ContactDispatchTable g_contactDispatchTable;
+
+namespace {
+	inline bool IsBipedLayer(UInt32 layer)
+	{
+		return layer == BGSCollisionLayer::kCollisionLayer_Biped || layer == BGSCollisionLayer::kCollisionLayer_BipedNoCC;
+	}
+
+	inline bool IsClutterLayer(UInt32 layer)
+	{
+		return layer == BGSCollisionLayer::kCollisionLayer_Clutter || layer == BGSCollisionLayer::kCollisionLayer_Weapon;
+	}
+}
+
+void ContactDispatchTable::Build(UInt8 (&table)[128][128], UInt32 higgsLayer)
+{
+	bool doCharControllerVsClutter = Config::options.disableClutterVsCharacterControllerCollisionForActiveActors;
+	bool doBipedVsBiped =
+		Config::options.overrideSoundVelForRagdollCollisions ||
+		Config::options.stopRagdollNonSelfCollisionForCloseActors ||
+		Config::options.stopRagdollNonSelfCollisionForActorsWithVehicle;
+
+	for (UInt32 layerA = 0; layerA < 128; layerA++) {
+		for (UInt32 layerB = 0; layerB < 128; layerB++) {
+			UInt8 handlers = 0;
+
+			if (doCharControllerVsClutter) {
+				if ((layerA == BGSCollisionLayer::kCollisionLayer_CharController && IsClutterLayer(layerB)) ||
+					(layerB == BGSCollisionLayer::kCollisionLayer_CharController && IsClutterLayer(layerA))) {
+					handlers |= ContactHandler::CharControllerVsClutter;
+				}
+			}
+
+			// Always needed, since it disables collisions between clutter and bipeds that aren't actors
+			if ((IsBipedLayer(layerA) && IsClutterLayer(layerB)) || (IsBipedLayer(layerB) && IsClutterLayer(layerA))) {
+				handlers |= ContactHandler::BipedVsClutter;
+			}
+
+			if (doBipedVsBiped && IsBipedLayer(layerA) && IsBipedLayer(layerB)) {
+				handlers |= ContactHandler::BipedVsBiped;
+			}
+
+			if (layerA == higgsLayer && layerB == higgsLayer) {
+				handlers |= ContactHandler::BothHiggs;
+			}
+			else if (layerA == higgsLayer || layerB == higgsLayer) {
+				handlers |= ContactHandler::Higgs;
+			}
+
+			table[layerA][layerB] = handlers;
+		}
+	}
+}
+
+void ContactDispatchTable::Validate(UInt32 higgsLayer)
+{
+	if (isBuilt && optionsVersion == Config::optionsVersion && builtHiggsLayer == higgsLayer) return;
+
+	int next = isBuilt ? 1 - current.load(std::memory_order_relaxed) : 0;
+	Build(tables[next], higgsLayer);
+	current.store(next, std::memory_order_release);
+
+	optionsVersion = Config::optionsVersion;
+	builtHiggsLayer = higgsLayer;
+	isBuilt = true;
+}
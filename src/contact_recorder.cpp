@@ -0,0 +1,79 @@
+#include "contact_recorder.h"
+#include "config.h"
+
+
+ContactRecorder g_contactRecorder;
+
+void ContactRecorder::BeginStep(double frameTime)
+{
+	if (!Config::options.recordContactEvents) {
+		if (IsRecording()) {
+			Close();
+		}
+		return;
+	}
+
+	std::scoped_lock scopedLock(lock);
+
+	if (!IsRecording()) {
+		if (failedOptionsVersion == Config::optionsVersion) return; // don't retry until the options change
+
+		file.open(Config::options.contactRecordingPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			_ERROR("Failed to open contact recording file %s", Config::options.contactRecordingPath.c_str());
+			file.clear();
+			failedOptionsVersion = Config::optionsVersion;
+			return;
+		}
+
+		ContactRecord::FileHeader header{ ContactRecord::Magic, ContactRecord::Version };
+		file.write((const char *)&header, sizeof(header));
+
+		_MESSAGE("Recording contacts to %s", Config::options.contactRecordingPath.c_str());
+		optionsVersion = 0;
+		stepIndex = 0;
+		isRecording.store(true, std::memory_order_relaxed);
+	}
+
+	if (optionsVersion != Config::optionsVersion) {
+		ContactRecord::Config config{
+			Config::GetHitClassificationOptions(),
+			Config::options.hitCooldownTimeStoppedColliding,
+			Config::options.hitCooldownTimeFallback
+		};
+		Write(ContactRecord::Type::Config, config);
+		optionsVersion = Config::optionsVersion;
+	}
+
+	Write(ContactRecord::Type::Step, ContactRecord::Step{ frameTime, stepIndex++ });
+}
+
+void ContactRecorder::RecordContact(const ContactRecord::Contact &contact)
+{
+	if (!IsRecording()) return;
+
+	std::scoped_lock scopedLock(lock);
+	if (file.is_open()) {
+		Write(ContactRecord::Type::Contact, contact);
+	}
+}
+
+void ContactRecorder::RecordControllerSample(const ContactRecord::ControllerSample &sample)
+{
+	if (!IsRecording()) return;
+
+	std::scoped_lock scopedLock(lock);
+	if (file.is_open()) {
+		Write(ContactRecord::Type::ControllerSample, sample);
+	}
+}
+
+void ContactRecorder::Close()
+{
+	std::scoped_lock scopedLock(lock);
+	if (!file.is_open()) return;
+
+	isRecording.store(false, std::memory_order_relaxed);
+	file.close();
+	_MESSAGE("Stopped recording contacts after %d physics steps", stepIndex);
+}
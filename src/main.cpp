@@ -45,6 +45,24 @@
 #include "higgsinterface001.h"
 #include "main.h"
 #include "blender.h"
+#include "worker_pool.h"
+#include "slot_map.h"
+#include "ragdoll_budget.h"
+#include "spatial_index.h"
+#include "actor_state_tracker.h"
+#include "collision_filter_queue.h"
+#include "race_cache.h"
+#include "flat_hash_map.h"
+#include "contact_dispatch.h"
+#include "body_info_cache.h"
+#include "per_thread_buffer.h"
+#include "expiring_map.h"
+#include "contact_recorder.h"
+#include "collision_group_flags.h"
+#include "collision_filter_table.h"
+#include "pre_physics_jobs.h"
+#include "timer_queue.h"
+#include "controller_velocity.h"
 
 
 // SKSE globals
@@ -359,81 +377,8 @@ float GetPhysicsDamage(float mass, float speed)
 	return damage;
 }
 
-struct GenericJob
-{
-	virtual void Run() = 0;
-};
-
-struct DelayedJob : GenericJob
-{
-	DelayedJob(std::function<void(void)> job, double delay) :
-		job(job)
-	{
-		runTime = g_currentFrameTime + delay;
-	}
-
-	virtual void Run() override
-	{
-		job();
-	}
-
-	double runTime = 0.0;
-	std::function<void(void)> job;
-};
-
-struct PointImpulseJob : GenericJob
-{
-	hkpRigidBody *rigidBody{};
-	NiPoint3 point{};
-	NiPoint3 impulse{};
-	UInt32 refrHandle{};
-
-	PointImpulseJob(hkpRigidBody *rigidBody, const NiPoint3 &point, const NiPoint3 &impulse, UInt32 refrHandle) :
-		rigidBody(rigidBody), point(point), impulse(impulse), refrHandle(refrHandle) {}
-
-	virtual void Run() override
-	{
-		// Need to be safe since the job could run next frame where the rigidbody might not exist anymore
-		if (NiPointer<TESObjectREFR> refr; LookupREFRByHandle(refrHandle, refr)) {
-			NiPointer<NiNode> root = refr->GetNiNode();
-			if (root && FindRigidBody(root, rigidBody)) {
-				if (IsMoveableEntity(rigidBody)) {
-					hkpEntity_activate(rigidBody);
-					rigidBody->m_motion.applyPointImpulse(NiPointToHkVector(impulse), NiPointToHkVector(point));
-					//_MESSAGE("Applied point impulse %.2f", VectorLength(impulse));
-				}
-			}
-		}
-	}
-};
-
-struct LinearImpulseJob : GenericJob
-{
-	hkpRigidBody *rigidBody{};
-	NiPoint3 impulse{};
-	UInt32 refrHandle{};
-
-	LinearImpulseJob(hkpRigidBody *rigidBody, const NiPoint3 &impulse, UInt32 refrHandle) :
-		rigidBody(rigidBody), impulse(impulse), refrHandle(refrHandle) {}
-
-	virtual void Run() override
-	{
-		// Need to be safe since the job could run next frame where the rigidbody might not exist anymore
-		if (NiPointer<TESObjectREFR> refr; LookupREFRByHandle(refrHandle, refr)) {
-			NiPointer<NiNode> root = refr->GetNiNode();
-			if (root && FindRigidBody(root, rigidBody)) {
-				if (IsMoveableEntity(rigidBody)) {
-					hkpEntity_activate(rigidBody);
-					rigidBody->m_motion.applyLinearImpulse(NiPointToHkVector(impulse));
-					//_MESSAGE("Applied linear impulse %.2f", VectorLength(impulse));
-				}
-			}
-		}
-	}
-};
-
-
-void UpdateCollisionFilterOnAllBones(Actor *actor)
+// The refresh is only queued, see CollisionFilterUpdateQueue
+void UpdateCollisionFilterOnAllBones(Actor *actor, hkpUpdateCollisionFilterOnEntityMode mode)
 {
 	if (Actor_IsInRagdollState(actor)) return;
 
@@ -452,15 +397,8 @@ void UpdateCollisionFilterOnAllBones(Actor *actor)
 					BSTSmartPointer<BShkbAnimationGraph> graph = manager->graphs.GetData()[i];
 					if (hkbRagdollDriver *driver = graph.ptr->character.ragdollDriver) {
 						if (hkaRagdollInstance *ragdoll = driver->ragdoll) {
-							if (ahkpWorld *world = (ahkpWorld *)ragdoll->getWorld()) {
-								bhkWorld *worldWrapper = world->m_userData;
-								{
-									BSWriteLocker lock(&worldWrapper->worldLock);
-
-									for (hkpRigidBody *body : ragdoll->m_rigidBodies) {
-										hkpWorld_UpdateCollisionFilterOnEntity(world, body, HK_UPDATE_FILTER_ON_ENTITY_FULL_CHECK, HK_UPDATE_COLLECTION_FILTER_IGNORE_SHAPE_COLLECTIONS);
-									}
-								}
+							for (hkpRigidBody *body : ragdoll->m_rigidBodies) {
+								g_collisionFilterUpdateQueue.Queue(body, mode);
 							}
 						}
 					}
@@ -470,73 +408,18 @@ void UpdateCollisionFilterOnAllBones(Actor *actor)
 	}
 }
 
-std::vector<std::unique_ptr<GenericJob>> g_prePhysicsStepJobs{};
-
-template<class T, typename... Args>
-void QueuePrePhysicsJob(Args&&... args)
-{
-	static_assert(std::is_base_of<GenericJob, T>::value);
-	g_prePhysicsStepJobs.push_back(std::make_unique<T>(std::forward<Args>(args)...));
-}
-
-std::vector<std::unique_ptr<DelayedJob>> g_delayedJobs{};
-
-void QueueDelayedJob(std::function<void(void)> job, double delay)
+// Runs the job once delay seconds have passed on the given clock
+TimerToken QueueDelayedJob(InlineJob job, double delay, TimerClock clock = TimerClock::Real)
 {
-	g_delayedJobs.push_back(std::make_unique<DelayedJob>(job, delay));
-}
-
-void RunDelayedJobs(double now)
-{
-	for (int i = 0; i < g_delayedJobs.size(); ++i) {
-		DelayedJob *job = g_delayedJobs[i].get();
-		if (now >= job->runTime) {
-			job->Run();
-
-			// Constant-time removal
-			std::swap(g_delayedJobs[i], g_delayedJobs.back());
-			g_delayedJobs.pop_back();
-
-			--i; // so that the increment brings it back to the current value
-		}
-	}
+	double now = clock == TimerClock::Game ? g_currentScaledFrameTime : g_currentFrameTime;
+	return g_timerQueue.Schedule(std::move(job), now + delay, clock);
 }
 
-struct ControllerVelocityData
-{
-	std::deque<NiPoint3> velocities{ 5, NiPoint3() };
-	NiPoint3 avgVelocity;
-	float avgSpeed;
-
-	void RecomputeAverageVelocity()
-	{
-		avgVelocity = std::accumulate(velocities.begin(), velocities.end(), NiPoint3()) / velocities.size();
-	}
-
-	void RecomputeAverageSpeed()
-	{
-		float speed = 0;
-		for (NiPoint3 &velocity : velocities) {
-			speed += VectorLength(velocity);
-		}
-		speed /= std::size(velocities);
-		avgSpeed = speed;
-	}
-
-	void Recompute()
-	{
-		RecomputeAverageVelocity();
-		RecomputeAverageSpeed();
-	}
-};
-ControllerVelocityData g_controllerVelocities[2]; // one for each hand
+ControllerVelocityData<NiPoint3> g_controllerVelocities[2]; // one for each hand
 
 std::unordered_set<Actor *> g_activeActors{};
-std::unordered_set<UInt16> g_activeBipedGroups{};
-std::unordered_set<UInt16> g_hittableCharControllerGroups{};
-std::unordered_set<UInt16> g_selfCollidableBipedGroups{};
 
-std::unordered_map<bhkRigidBody *, double> g_higgsLingeringRigidBodies{};
+ExpiringSet<bhkRigidBody *> g_higgsLingeringRigidBodies{}; // on the scaled clock
 bhkRigidBody * g_rightHand = nullptr;
 bhkRigidBody * g_leftHand = nullptr;
 bhkRigidBody * g_rightWeapon = nullptr;
@@ -551,48 +434,12 @@ UInt32 g_higgsCollisionLayer = 56;
 
 UInt16 g_playerCollisionGroup = 0;
 
-inline bool IsLeftRigidBody(hkpRigidBody *rigidBody)
-{
-	bhkRigidBody *wrapper = (bhkRigidBody *)rigidBody->m_userData;
-	if (!wrapper) return false;
-	return wrapper == g_leftHand || wrapper == g_leftWeapon || wrapper == g_leftHeldObject;
-}
-
-inline bool IsWeaponRigidBody(hkpRigidBody *rigidBody)
-{
-	bhkRigidBody *wrapper = (bhkRigidBody *)rigidBody->m_userData;
-	if (!wrapper) return false;
-	return wrapper == g_leftWeapon || wrapper == g_rightWeapon;
-}
-
-inline bool IsHandRigidBody(hkpRigidBody *rigidBody)
-{
-	bhkRigidBody *wrapper = (bhkRigidBody *)rigidBody->m_userData;
-	if (!wrapper) return false;
-	return wrapper == g_leftHand || wrapper == g_rightHand;
-}
-
-inline bool IsHeldRigidBody(hkpRigidBody *rigidBody)
-{
-	bhkRigidBody *wrapper = (bhkRigidBody *)rigidBody->m_userData;
-	if (!wrapper) return false;
-	return wrapper == g_leftHeldObject || wrapper == g_rightHeldObject;
-}
-
-inline bool IsHiggsRigidBody(hkpRigidBody *rigidBody)
-{
-	if ((rigidBody->getCollidable()->getBroadPhaseHandle()->getCollisionFilterInfo() & 0x7f) != g_higgsCollisionLayer) {
-		return false;
-	}
-	return IsHandRigidBody(rigidBody) || IsWeaponRigidBody(rigidBody) || IsHeldRigidBody(rigidBody);
-}
-
 inline bool IsHittableCharController(TESObjectREFR *refr)
 {
 	if (refr->formType == kFormType_Character) {
 		if (Actor *hitActor = DYNAMIC_CAST(refr, TESObjectREFR, Actor)) {
 			UInt32 filterInfo; Actor_GetCollisionFilterInfo(hitActor, filterInfo);
-			if (g_hittableCharControllerGroups.size() > 0 && g_hittableCharControllerGroups.count(filterInfo >> 16)) {
+			if (g_collisionGroupFlags.Get(filterInfo >> 16) & GroupFlags::Hittable) {
 				return true;
 			}
 		}
@@ -605,7 +452,8 @@ bool ShouldBumpActor(Actor *actor)
 {
 	if (!Config::options.enableBump) return false;
 	if (Actor_IsRunning(actor) || Actor_IsGhost(actor) || actor->IsInCombat() || Actor_IsInRagdollState(actor)) return false;
-	if (!actor->race || actor->race->data.unk40 >= 2) return false; // race size is >= large
+	UInt32 raceFlags = GetRaceFlags(actor->race);
+	if (!raceFlags || GetRaceSize(raceFlags) >= 2) return false; // race size is >= large
 	return true;
 }
 
@@ -613,7 +461,8 @@ bool ShouldShoveActor(Actor *actor)
 {
 	if (Actor_IsGhost(actor) || Actor_IsInRagdollState(actor)) return false;
 	if (!Config::options.enableShoveFromFurniture && IsActorUsingFurniture(actor)) return false;
-	if (!actor->race || actor->race->data.unk40 >= 2) return false; // race size is >= large or is child
+	UInt32 raceFlags = GetRaceFlags(actor->race);
+	if (!raceFlags || GetRaceSize(raceFlags) >= 2) return false; // race size is >= large or is child
 	return true;
 }
 
@@ -638,7 +487,8 @@ struct BumpRequest
 };
 std::mutex g_bumpActorsLock;
 std::unordered_map<Actor *, BumpRequest> g_bumpActors{};
-std::unordered_map<Actor *, double> g_shovedActors{};
+ExpiringSet<Actor *> g_shovedActors{};
+UInt32 g_expiryOptionsVersion = 0; // of the options the expiry times in g_shovedActors and g_higgsLingeringRigidBodies were worked out from
 
 void QueueBumpActor(Actor *actor, float bumpDirection, bool isLargeBump, bool exitFurniture, bool pauseCurrentDialogue = true, bool triggerDialogue = true)
 {
@@ -679,7 +529,8 @@ bool ShouldKeepOffset(Actor *actor)
 	if (Actor_IsGhost(actor)) return false;
 	if (IsActorUsingFurniture(actor)) return false;
 
-	if (!actor->race || actor->race->data.unk40 >= 2) return false; // race size is >= large
+	UInt32 raceFlags = GetRaceFlags(actor->race);
+	if (!raceFlags || GetRaceSize(raceFlags) >= 2) return false; // race size is >= large
 
 	return true;
 }
@@ -695,10 +546,10 @@ bool ShouldRagdollOnGrab(Actor *actor)
 {
 	if (!Config::options.ragdollOnGrab) return false;
 
-	TESRace *race = actor->race;
-	if (!race) return false;
+	UInt32 raceFlags = GetRaceFlags(actor->race);
+	if (!raceFlags) return false;
 
-	if (Config::options.ragdollSmallRacesOnGrab && race->data.unk40 == 0) return true; // small race
+	if (Config::options.ragdollSmallRacesOnGrab && GetRaceSize(raceFlags) == 0) return true; // small race
 
 	float health = actor->actorValueOwner.GetCurrent(24);
 	if (health < Config::options.smallRaceHealthThreshold) return true;
@@ -724,20 +575,30 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 		Type type;
 	};
 
-	std::map<std::pair<hkpRigidBody *, hkpRigidBody *>, int> activeCollisions{};
-	std::unordered_set<hkpRigidBody *> collidedRigidbodies{};
-	std::unordered_set<TESObjectREFR *> collidedRefs{};
-	std::unordered_set<TESObjectREFR *> handCollidedRefs{};
+	FlatHashMap<std::pair<hkpRigidBody *, hkpRigidBody *>, int> activeCollisions{};
+	FlatHashSet<hkpRigidBody *> collidedRigidbodies{};
+	FlatHashSet<TESObjectREFR *> collidedRefs{};
+	FlatHashSet<TESObjectREFR *> handCollidedRefs{};
 
 	struct CooldownData
 	{
 		double startTime = 0.0;
 		double stoppedCollidingTime = 0.0;
 	};
-	std::unordered_map<TESObjectREFR *, CooldownData> hitCooldownTargets[2]{}; // each hand has its own cooldown
-	std::unordered_map<TESObjectREFR *, double> collisionCooldownTargets[2]{};
-	std::map<std::pair<Actor *, hkpRigidBody *>, double> physicsHitCooldownTargets{};
-	std::vector<CollisionEvent> events{};
+	ExpiringMap<TESObjectREFR *, CooldownData> hitCooldownTargets[2]{}; // each hand has its own cooldown
+	ExpiringSet<TESObjectREFR *> collisionCooldownTargets[2]{};
+	ExpiringSet<std::pair<Actor *, hkpRigidBody *>> physicsHitCooldownTargets{}; // on the scaled clock
+	UInt32 cooldownOptionsVersion = 0; // of the options the cooldown expiry times were worked out from
+
+	static inline double GetHitCooldownExpiryTime(const CooldownData &cooldown)
+	{
+		return min(cooldown.stoppedCollidingTime + Config::options.hitCooldownTimeStoppedColliding, cooldown.startTime + Config::options.hitCooldownTimeFallback);
+	}
+
+	// Contact callbacks can come from several simulation threads at once
+	PerThreadBuffer<CollisionEvent> events{};
+	std::vector<CollisionEvent> mergedEvents{};
+	std::mutex hitLock{}; // guards the hit cooldowns and everything a hit queues up
 
 	inline std::pair<hkpRigidBody *, hkpRigidBody *> SortPair(hkpRigidBody *a, hkpRigidBody *b) {
 		if ((uint64_t)a <= (uint64_t)b) return { a, b };
@@ -772,18 +633,18 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 		// Apply linear impulse at the center of mass to all bodies within 2 ragdoll constraints
 		ForEachRagdollDriver(actor, [this, rigidBody, hitVelocity, impulseMult, targetHandle](hkbRagdollDriver *driver) {
 			ForEachAdjacentBody(driver, rigidBody, [this, driver, hitVelocity, impulseMult, targetHandle](hkpRigidBody *adjacentBody) {
-				QueuePrePhysicsJob<LinearImpulseJob>(adjacentBody, CalculateHitImpulse(adjacentBody, hitVelocity, impulseMult) * Config::options.hitImpulseDecayMult1, targetHandle);
+				g_prePhysicsJobs.QueueLinearImpulse(adjacentBody, CalculateHitImpulse(adjacentBody, hitVelocity, impulseMult) * Config::options.hitImpulseDecayMult1, targetHandle);
 				ForEachAdjacentBody(driver, adjacentBody, [this, driver, hitVelocity, impulseMult, targetHandle](hkpRigidBody *adjacentBody) {
-					QueuePrePhysicsJob<LinearImpulseJob>(adjacentBody, CalculateHitImpulse(adjacentBody, hitVelocity, impulseMult) * Config::options.hitImpulseDecayMult2, targetHandle);
+					g_prePhysicsJobs.QueueLinearImpulse(adjacentBody, CalculateHitImpulse(adjacentBody, hitVelocity, impulseMult) * Config::options.hitImpulseDecayMult2, targetHandle);
 					ForEachAdjacentBody(driver, adjacentBody, [this, hitVelocity, impulseMult, targetHandle](hkpRigidBody *adjacentBody) {
-						QueuePrePhysicsJob<LinearImpulseJob>(adjacentBody, CalculateHitImpulse(adjacentBody, hitVelocity, impulseMult) * Config::options.hitImpulseDecayMult3, targetHandle);
+						g_prePhysicsJobs.QueueLinearImpulse(adjacentBody, CalculateHitImpulse(adjacentBody, hitVelocity, impulseMult) * Config::options.hitImpulseDecayMult3, targetHandle);
 					});
 				});
 			});
 		});
 
 		// Apply a point impulse at the hit location to the body we actually hit
-		QueuePrePhysicsJob<PointImpulseJob>(rigidBody, position, CalculateHitImpulse(rigidBody, hitVelocity, impulseMult), targetHandle);
+		g_prePhysicsJobs.QueuePointImpulse(rigidBody, position, CalculateHitImpulse(rigidBody, hitVelocity, impulseMult), targetHandle);
 	}
 
 	void DoHit(TESObjectREFR *hitRefr, hkpRigidBody *hitRigidBody, hkpRigidBody *hittingRigidBody, const hkpContactPointEvent &evnt, const NiPoint3 &hitPosition, const NiPoint3 &hitVelocity, TESForm *weapon, float impulseMult, bool isLeft, bool isOffhand, bool isTwoHanding)
@@ -839,7 +700,8 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 			}
 		}
 
-		hitCooldownTargets[isLeft][hitRefr] = { g_currentFrameTime, g_currentFrameTime };
+		CooldownData cooldown{ g_currentFrameTime, g_currentFrameTime };
+		hitCooldownTargets[isLeft].Set(hitRefr, cooldown, GetHitCooldownExpiryTime(cooldown));
 	}
 
 	void ApplyPhysicsDamage(Actor *source, Actor *target, bhkRigidBody *collidingBody, NiPoint3 &hitPos, NiPoint3 &hitNormal)
@@ -874,7 +736,7 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 			if (hitData.totalDamage > 0.f) {
 				Actor_GetHit(target, hitData);
 				if (Config::options.physicsHitRecoveryTime > 0) {
-					physicsHitCooldownTargets[{ target, collidingBody->hkBody }] = g_currentFrameTime;
+					physicsHitCooldownTargets.Set({ target, collidingBody->hkBody }, g_currentScaledFrameTime + Config::options.physicsHitRecoveryTime);
 				}
 			}
 		}
@@ -892,89 +754,77 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 		UInt32 layerA = rigidBodyA->m_collidable.m_broadPhaseHandle.m_collisionFilterInfo & 0x7f;
 		UInt32 layerB = rigidBodyB->m_collidable.m_broadPhaseHandle.m_collisionFilterInfo & 0x7f;
 
-		if ((layerA == BGSCollisionLayer::kCollisionLayer_CharController && (layerB == BGSCollisionLayer::kCollisionLayer_Clutter || layerB == BGSCollisionLayer::kCollisionLayer_Weapon)) ||
-			(layerB == BGSCollisionLayer::kCollisionLayer_CharController && (layerA == BGSCollisionLayer::kCollisionLayer_Clutter || layerA == BGSCollisionLayer::kCollisionLayer_Weapon))) {
-			if (Config::options.disableClutterVsCharacterControllerCollisionForActiveActors) {
-				hkpCollidable *charControllerCollidable = layerA == BGSCollisionLayer::kCollisionLayer_CharController ? &rigidBodyA->m_collidable : &rigidBodyB->m_collidable;
-				if (NiPointer<TESObjectREFR> refr = GetRefFromCollidable(charControllerCollidable)) {
-					if (refr->formType == kFormType_Character) {
-						if (Actor *actor = DYNAMIC_CAST(refr, TESObjectREFR, Actor)) {
-							if (g_activeActors.count(actor)) {
-								// We'll let the clutter object collide with the biped instead
-								evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
-								return;
-							}
-						}
-					}
+		// One lookup tells us which of the handlers below apply to this pair of layers, most pairs don't need any
+		UInt8 handlers = g_contactDispatchTable.Get(layerA, layerB);
+		if (!handlers) return;
+
+		if (handlers & ContactHandler::CharControllerVsClutter) {
+			hkpRigidBody *charControllerBody = layerA == BGSCollisionLayer::kCollisionLayer_CharController ? rigidBodyA : rigidBodyB;
+			BodyInfo info = g_bodyInfoCache.Get(charControllerBody);
+			if (info.refr && info.refr->formType == kFormType_Character) {
+				if (info.actor && g_activeActors.count(info.actor)) {
+					// We'll let the clutter object collide with the biped instead
+					evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
+					return;
 				}
 			}
 		}
 
-		if (((layerA == BGSCollisionLayer::kCollisionLayer_Biped || layerA == BGSCollisionLayer::kCollisionLayer_BipedNoCC) && (layerB == BGSCollisionLayer::kCollisionLayer_Clutter || layerB == BGSCollisionLayer::kCollisionLayer_Weapon)) ||
-			((layerB == BGSCollisionLayer::kCollisionLayer_Biped || layerB == BGSCollisionLayer::kCollisionLayer_BipedNoCC) && (layerA == BGSCollisionLayer::kCollisionLayer_Clutter || layerA == BGSCollisionLayer::kCollisionLayer_Weapon))) {
-			if (NiPointer<TESObjectREFR> refrA = GetRefFromCollidable(&rigidBodyA->m_collidable)) {
-				if (NiPointer<TESObjectREFR> refrB = GetRefFromCollidable(&rigidBodyB->m_collidable)) {
-					bool isATarget = refrA->formType == kFormType_Character;
-					Actor *actor = DYNAMIC_CAST(isATarget ? refrA : refrB, TESObjectREFR, Actor);
-					if (!actor) {
-						// Disable collision with biped objects that are not actors
-						evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
-						return;
-					}
+		if (handlers & ContactHandler::BipedVsClutter) {
+			BodyInfo infoA = g_bodyInfoCache.Get(rigidBodyA);
+			BodyInfo infoB = g_bodyInfoCache.Get(rigidBodyB);
+			if (infoA.refr && infoB.refr) {
+				bool isATarget = infoA.refr->formType == kFormType_Character;
+				Actor *actor = isATarget ? infoA.actor : infoB.actor;
+				if (!actor) {
+					// Disable collision with biped objects that are not actors
+					evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
+					return;
+				}
 
-					if (Config::options.doClutterVsBipedCollisionDamage) {
-						hkpRigidBody *hittingBody = isATarget ? rigidBodyB : rigidBodyA;
-						if (!physicsHitCooldownTargets.count({ actor, hittingBody })) {
-							bhkRigidBody *collidingRigidBody = (bhkRigidBody *)hittingBody->m_userData;
-							Actor *aggressor = g_higgsLingeringRigidBodies.count(collidingRigidBody) ? *g_thePlayer : nullptr;
-							ApplyPhysicsDamage(aggressor, actor, collidingRigidBody, HkVectorToNiPoint(evnt.m_contactPoint->getPosition()), HkVectorToNiPoint(evnt.m_contactPoint->getNormal()));
-						}
+				if (Config::options.doClutterVsBipedCollisionDamage) {
+					hkpRigidBody *hittingBody = isATarget ? rigidBodyB : rigidBodyA;
+					std::scoped_lock lock(hitLock);
+					if (!physicsHitCooldownTargets.count({ actor, hittingBody })) {
+						bhkRigidBody *collidingRigidBody = (bhkRigidBody *)hittingBody->m_userData;
+						Actor *aggressor = g_higgsLingeringRigidBodies.count(collidingRigidBody) ? *g_thePlayer : nullptr;
+						ApplyPhysicsDamage(aggressor, actor, collidingRigidBody, HkVectorToNiPoint(evnt.m_contactPoint->getPosition()), HkVectorToNiPoint(evnt.m_contactPoint->getNormal()));
 					}
 				}
 			}
 		}
 
-		if ((layerA == BGSCollisionLayer::kCollisionLayer_Biped || layerA == BGSCollisionLayer::kCollisionLayer_BipedNoCC) && (layerB == BGSCollisionLayer::kCollisionLayer_Biped || layerB == BGSCollisionLayer::kCollisionLayer_BipedNoCC)) {
+		if (handlers & ContactHandler::BipedVsBiped) {
 			if (Config::options.overrideSoundVelForRagdollCollisions) {
 				// Disable collision sounds for this frame
 				*g_fMinSoundVel = Config::options.ragdollSoundVel;
 			}
 
-			if (Config::options.stopRagdollNonSelfCollisionForCloseActors) {
-				if (NiPointer<TESObjectREFR> refrA = GetRefFromCollidable(&rigidBodyA->m_collidable)) {
-					if (NiPointer<TESObjectREFR> refrB = GetRefFromCollidable(&rigidBodyB->m_collidable)) {
-						if (refrA != refrB) {
-							if (VectorLength(refrA->pos - refrB->pos) < Config::options.closeActorMinDistance) {
-								// Disable collision between bipeds whose references are roughly in the same position
-								evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
-								return;
-							}
+			if (Config::options.stopRagdollNonSelfCollisionForCloseActors || Config::options.stopRagdollNonSelfCollisionForActorsWithVehicle) {
+				BodyInfo infoA = g_bodyInfoCache.Get(rigidBodyA);
+				BodyInfo infoB = g_bodyInfoCache.Get(rigidBodyB);
+				if (infoA.refr && infoB.refr && infoA.refr != infoB.refr) {
+					if (Config::options.stopRagdollNonSelfCollisionForCloseActors) {
+						if (g_spatialIndex.AreWithinDistance(infoA.refr, infoB.refr, Config::options.closeActorMinDistance)) {
+							// Disable collision between bipeds whose references are roughly in the same position
+							evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
+							return;
 						}
 					}
-				}
-			}
 
-			if (Config::options.stopRagdollNonSelfCollisionForActorsWithVehicle) {
-				if (NiPointer<TESObjectREFR> refrA = GetRefFromCollidable(&rigidBodyA->m_collidable)) {
-					if (NiPointer<TESObjectREFR> refrB = GetRefFromCollidable(&rigidBodyB->m_collidable)) {
-						if (refrA != refrB) {
-							if (Actor *actorA = DYNAMIC_CAST(refrA, TESObjectREFR, Actor)) {
-								if (Actor *actorB = DYNAMIC_CAST(refrB, TESObjectREFR, Actor)) {
-									if (GetVehicleHandle(actorA) != *g_invalidRefHandle && GetVehicleHandle(actorB) != *g_invalidRefHandle) {
-										evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
-										return;
-									}
-								}
-							}
+					if (Config::options.stopRagdollNonSelfCollisionForActorsWithVehicle) {
+						if (infoA.actor && infoB.actor && infoA.Has(BodyFlags::InVehicle) && infoB.Has(BodyFlags::InVehicle)) {
+							evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
+							return;
 						}
 					}
 				}
 			}
 		}
 
-		if (layerA != g_higgsCollisionLayer && layerB != g_higgsCollisionLayer) return; // Every collision we care about involves a body on the higgs layer (hand, held object...)
+		if (!(handlers & (ContactHandler::Higgs | ContactHandler::BothHiggs))) return; // Every collision we care about involves a body on the higgs layer (hand, held object...)
 
-		if (layerA == g_higgsCollisionLayer && layerB == g_higgsCollisionLayer) {
+		if (handlers & ContactHandler::BothHiggs) {
 			// Both objects are on the higgs layer
 			if (!IsMoveableEntity(rigidBodyA) && !IsMoveableEntity(rigidBodyB)) {
 				evnt.m_contactPointProperties->m_flags |= hkpContactPointProperties::CONTACT_IS_DISABLED;
@@ -994,7 +844,7 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 			return;
 		}
 
-		NiPointer<TESObjectREFR> hitRefr = GetRefFromCollidable(&hitRigidBody->m_collidable);
+		NiPointer<TESObjectREFR> hitRefr = g_bodyInfoCache.Get(hitRigidBody).refr;
 		if (!hitRefr) {
 			if (hittingRigidBody->getQualityType() == hkpCollidableQualityType::HK_COLLIDABLE_QUALITY_KEYFRAMED_REPORTING && !IsMoveableEntity(hitRigidBody)) {
 				// It's not a hit, so disable contact for keyframed/fixed objects in this case
@@ -1011,7 +861,9 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 
 		UInt32 hitLayer = hitRigidBody == rigidBodyA ? layerA : layerB;
 
-		bool isLeft = IsLeftRigidBody(hittingRigidBody);
+		bool isLeft = g_bodyInfoCache.Get(hittingRigidBody).Has(BodyFlags::Left);
+
+		std::scoped_lock lock(hitLock);
 
 		if (hitCooldownTargets[isLeft].count(hitRefr)) {
 			// refr is currently under a hit cooldown, so disable the contact point and gtfo
@@ -1035,51 +887,60 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 		TESForm *equippedObj = player->GetEquippedObject(isOffhand);
 		TESObjectWEAP *weap = DYNAMIC_CAST(equippedObj, TESForm, TESObjectWEAP);
 
-		NiPoint3 handDirection = VectorNormalized(g_controllerVelocities[isLeft].avgVelocity);
-		float handSpeedRoomspace = g_controllerVelocities[isLeft].avgSpeed;
+		NiPoint3 handDirection;
+		float handSpeedRoomspace;
 		bool isTwoHanding = g_higgsInterface->IsTwoHanding();
-		if (isTwoHanding) {
-			handDirection = VectorNormalized(g_controllerVelocities[0].avgVelocity + g_controllerVelocities[1].avgVelocity);
-			handSpeedRoomspace = max(g_controllerVelocities[0].avgSpeed, g_controllerVelocities[1].avgSpeed);
-		}
+		GetHandMotion(g_controllerVelocities, isLeft, isTwoHanding, handDirection, handSpeedRoomspace);
+		NiPoint3 referenceDirection; // weapon or hand direction that the hand direction is compared against, if any
 
-		bool isStab = false, isPunch = false, isSwing = false;
+		HitClassificationInput hitInput{ hitSpeed, 0.f, 0.f, handSpeedRoomspace, HitWeaponType::Other, false, player->actorState.IsWeaponDrawn() };
 		if (weap && CanWeaponStab(weap)) {
 			// Check for stab
 			// All stabbable weapons use the melee weapon offset node
+			hitInput.weaponType = HitWeaponType::Stabbing;
 			NiPointer<NiAVObject> weaponOffsetNode = player->unk3F0[isLeft ? PlayerCharacter::Node::kNode_LeftMeleeWeaponOffsetNode : PlayerCharacter::Node::kNode_RightMeleeWeaponOffsetNode];
 			if (weaponOffsetNode) {
 				// Use last frame's offset node transform because this frame is not over yet and it can still be modified by e.g. higgs two-handing
 				NiPoint3 weaponForward = ForwardVector(weaponOffsetNode->m_oldWorldTransform.rot);
-				float stabAmount = DotProduct(handDirection, weaponForward);
-				//_MESSAGE("Stab amount: %.2f", stabAmount);
-				if (stabAmount > Config::options.hitStabDirectionThreshold && hitSpeed > Config::options.hitStabSpeedThreshold) {
-					isStab = true;
-				}
+				hitInput.stabAmount = DotProduct(handDirection, weaponForward);
+				referenceDirection = weaponForward;
+				hitInput.hasWeaponNode = true;
+				//_MESSAGE("Stab amount: %.2f", hitInput.stabAmount);
 			}
 		}
 		else if (!equippedObj || (weap && weap->type() == TESObjectWEAP::GameData::kType_HandToHandMelee)) {
 			// Check for punch
 			// For punching use the hand node
+			hitInput.weaponType = HitWeaponType::Unarmed;
 			NiPointer<NiAVObject> handNode = player->unk3F0[isLeft ? PlayerCharacter::Node::kNode_LeftHandBone: PlayerCharacter::Node::kNode_RightHandBone];
 			if (handNode) {
 				NiPoint3 punchVector = UpVector(handNode->m_worldTransform.rot); // in the direction of fingers when fingers are extended
-				float punchAmount = DotProduct(handDirection, punchVector);
-				//_MESSAGE("Punch amount: %.2f", punchAmount);
-				if (punchAmount > Config::options.hitPunchDirectionThreshold && hitSpeed > Config::options.hitPunchSpeedThreshold) {
-					isPunch = true;
-				}
+				hitInput.punchAmount = DotProduct(handDirection, punchVector);
+				referenceDirection = punchVector;
+				hitInput.hasWeaponNode = true;
+				//_MESSAGE("Punch amount: %.2f", hitInput.punchAmount);
 			}
 		}
-		
-		if (!isStab && !isPunch && hitSpeed > Config::options.hitSwingSpeedThreshold) {
-			isSwing = true;
-		}
 
-		// Thresholding on some (small) roomspace hand velocity helps prevent hits while moving around / turning
+		HitClassification hit = ClassifyHit(hitInput, Config::GetHitClassificationOptions());
+
+		if (g_contactRecorder.IsRecording()) {
+			NiPoint3 hkHitPosition = HkVectorToNiPoint(hkHitPos);
+			ContactRecord::Contact contact{
+				(UInt64)hitRigidBody, (UInt64)hittingRigidBody, (UInt64)hitRefr.get(),
+				(UInt8)hitLayer, (UInt8)(hitLayer == layerA ? layerB : layerA), isLeft, isTwoHanding,
+				{ hkHitPosition.x, hkHitPosition.y, hkHitPosition.z },
+				{ hkHitVelocity.x, hkHitVelocity.y, hkHitVelocity.z },
+				{ referenceDirection.x, referenceDirection.y, referenceDirection.z },
+				hitInput, hit
+			};
+			g_contactRecorder.RecordContact(contact);
+		}
 
-		bool doHit = (isSwing || isStab || isPunch);
-		bool disableHit = handSpeedRoomspace < Config::options.hitRequiredHandSpeedRoomspace || (!player->actorState.IsWeaponDrawn() && Config::options.disableHitIfSheathed);
+		bool isStab = hit.type == HitType::Stab;
+		bool isPunch = hit.type == HitType::Punch;
+		bool doHit = hit.type != HitType::None;
+		bool disableHit = hit.isDisabled;
 
 		if (doHit && !disableHit) {
 			float havokWorldScale = *g_havokWorldScale;
@@ -1134,7 +995,7 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 
 		if (layerA == g_higgsCollisionLayer && layerB == g_higgsCollisionLayer) return; // Both objects are on the higgs layer
 
-		events.push_back({ rigidBodyA, rigidBodyB, CollisionEvent::Type::Added });
+		events.Append({ rigidBodyA, rigidBodyB, CollisionEvent::Type::Added });
 		//_MESSAGE("%d Added %x %x", *g_currentFrameCounter, (UInt64)rigidBodyA, (UInt64)rigidBodyB);
 	}
 
@@ -1144,7 +1005,7 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 		hkpRigidBody *rigidBodyB = evnt.m_bodies[1];
 
 		// Technically our objects could have changed layers or something between added and removed
-		events.push_back({ rigidBodyA, rigidBodyB, CollisionEvent::Type::Removed });
+		events.Append({ rigidBodyA, rigidBodyB, CollisionEvent::Type::Removed });
 		//_MESSAGE("%d Removed %x %x", *g_currentFrameCounter, (UInt64)rigidBodyA, (UInt64)rigidBodyB);
 	}
 
@@ -1155,49 +1016,48 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 
 		// First just accumulate adds/removes. Why? While Added always occurs before Removed for a single contact point,
 		// a single pair of rigid bodies can have multiple contact points, and adds/removes between these different contact points can be non-deterministic.
-		for (CollisionEvent &evnt : events) {
+		// The events from each simulation thread are merged and sorted by body pair, so the result doesn't depend on how the work was split between threads.
+		events.Drain(mergedEvents);
+		std::sort(mergedEvents.begin(), mergedEvents.end(), [this](const CollisionEvent &a, const CollisionEvent &b) {
+			auto pairA = SortPair(a.rbA, a.rbB), pairB = SortPair(b.rbA, b.rbB);
+			if (pairA != pairB) return pairA < pairB;
+			return a.type < b.type;
+		});
+		for (CollisionEvent &evnt : mergedEvents) {
 			if (evnt.type == CollisionEvent::Type::Added) {
-				auto pair = SortPair(evnt.rbA, evnt.rbB);
-				int count = activeCollisions.count(pair) ? activeCollisions[pair] : 0;
-				activeCollisions[pair] = count + 1;
+				activeCollisions[SortPair(evnt.rbA, evnt.rbB)] += 1;
 			}
 			else if (evnt.type == CollisionEvent::Type::Removed) {
-				auto pair = SortPair(evnt.rbA, evnt.rbB);
-				int count = activeCollisions.count(pair) ? activeCollisions[pair] : 0;
-				activeCollisions[pair] = count - 1;
+				activeCollisions[SortPair(evnt.rbA, evnt.rbB)] -= 1;
 			}
 		}
-		events.clear();
+		mergedEvents.clear();
 
 		// Clear out any collisions that are no longer active (or that were only removed, since we do events for any removes but only some adds)
 		collidedRigidbodies.clear();
 		collidedRefs.clear();
 		handCollidedRefs.clear();
-		for (auto it = activeCollisions.begin(); it != activeCollisions.end();) {
-			auto[pair, count] = *it;
-			if (count <= 0) {
-				it = activeCollisions.erase(it);
-			}
-			else {
-				auto[bodyA, bodyB] = pair;
-				hkpRigidBody *collidedBody = IsHiggsRigidBody(bodyA) ? bodyB : bodyA;
-				collidedRigidbodies.insert(collidedBody);
+		activeCollisions.EraseIf([this](const std::pair<hkpRigidBody *, hkpRigidBody *> &pair, int count) {
+			if (count <= 0) return true;
 
-				if (TESObjectREFR *ref = GetRefFromCollidable(collidedBody->getCollidable())) {
-					collidedRefs.insert(ref);
+			auto[bodyA, bodyB] = pair;
+			hkpRigidBody *collidedBody = g_bodyInfoCache.Get(bodyA).Has(BodyFlags::Higgs) ? bodyB : bodyA;
+			collidedRigidbodies.insert(collidedBody);
 
-					hkpRigidBody *collidingBody = collidedBody == bodyA ? bodyB : bodyA;
-					if (IsHandRigidBody(collidingBody)) {
-						handCollidedRefs.insert(ref);
-					}
-				}
+			if (TESObjectREFR *ref = g_bodyInfoCache.Get(collidedBody).refr) {
+				collidedRefs.insert(ref);
 
-				++it;
+				hkpRigidBody *collidingBody = collidedBody == bodyA ? bodyB : bodyA;
+				if (g_bodyInfoCache.Get(collidingBody).Has(BodyFlags::Hand)) {
+					handCollidedRefs.insert(ref);
+				}
 			}
-		}
+
+			return false;
+		});
 
 		// Now fill in the currently collided-with actors based on active collisions
-		for (auto[pair, count] : activeCollisions) {
+		activeCollisions.ForEach([this](const std::pair<hkpRigidBody *, hkpRigidBody *> &pair, int count) {
 			auto[rigidBodyA, rigidBodyB] = pair;
 
 			UInt32 layerA = rigidBodyA->m_collidable.m_broadPhaseHandle.m_collisionFilterInfo & 0x7f;
@@ -1206,47 +1066,59 @@ struct ContactListener : hkpContactListener, hkpWorldPostSimulationListener
 			hkpRigidBody *hitRigidBody = layerA == g_higgsCollisionLayer ? rigidBodyB : rigidBodyA;
 			hkpRigidBody *hittingRigidBody = hitRigidBody == rigidBodyA ? rigidBodyB : rigidBodyA;
 
-			NiPointer<TESObjectREFR> hitRefr = GetRefFromCollidable(&hitRigidBody->m_collidable);
+			NiPointer<TESObjectREFR> hitRefr = g_bodyInfoCache.Get(hitRigidBody).refr;
 			if (hitRefr) {
-				bool isLeft = IsLeftRigidBody(hittingRigidBody);
-				if (hitCooldownTargets[isLeft].count(hitRefr)) {
+				bool isLeft = g_bodyInfoCache.Get(hittingRigidBody).Has(BodyFlags::Left);
+				if (CooldownData *cooldown = hitCooldownTargets[isLeft].find(hitRefr)) {
 					// refr is still collided with, so refresh its hit cooldown
-					hitCooldownTargets[isLeft][hitRefr].stoppedCollidingTime = g_currentFrameTime;
+					cooldown->stoppedCollidingTime = g_currentFrameTime;
+					hitCooldownTargets[isLeft].SetExpiryTime(hitRefr, GetHitCooldownExpiryTime(*cooldown));
 				}
 			}
+		});
+
+		// Expiry times are worked out from the options when a cooldown starts. After a config reload, hit cooldowns are recomputed from when they started,
+		// and the cooldowns that only know their expiry time are dropped.
+		if (cooldownOptionsVersion != Config::optionsVersion) {
+			for (auto &targets : hitCooldownTargets) {
+				targets.UpdateExpiryTimes([](TESObjectREFR *, const CooldownData &cooldown) { return GetHitCooldownExpiryTime(cooldown); });
+			}
+			for (auto &targets : collisionCooldownTargets) {
+				targets.clear();
+			}
+			physicsHitCooldownTargets.clear();
+			cooldownOptionsVersion = Config::optionsVersion;
 		}
 
 		// Clear out old hit cooldown targets
 		for (auto &targets : hitCooldownTargets) { // For each hand's cooldown targets
-			for (auto it = targets.begin(); it != targets.end();) {
-				auto[target, cooldown] = *it;
-				if ((g_currentFrameTime - cooldown.stoppedCollidingTime) > Config::options.hitCooldownTimeStoppedColliding ||
-					(g_currentFrameTime - cooldown.startTime) > Config::options.hitCooldownTimeFallback)
-					it = targets.erase(it);
-				else
-					++it;
-			}
+			targets.Expire(g_currentFrameTime);
 		}
 
 		// Clear out old physics hit cooldown targets
-		for (auto it = physicsHitCooldownTargets.begin(); it != physicsHitCooldownTargets.end();) {
-			auto[target, hitTime] = *it;
-			if ((g_currentFrameTime - hitTime) * *g_globalTimeMultiplier > Config::options.physicsHitRecoveryTime)
-				it = physicsHitCooldownTargets.erase(it);
-			else
-				++it;
-		}
+		physicsHitCooldownTargets.Expire(g_currentScaledFrameTime);
 
 		// Clear out old collision cooldown targets
 		for (auto &targets : collisionCooldownTargets) { // For each hand's cooldown targets
-			for (auto it = targets.begin(); it != targets.end();) {
-				auto[target, disabledTime] = *it;
-				if ((g_currentFrameTime - disabledTime) > Config::options.collisionCooldownTime)
-					it = targets.erase(it);
-				else
-					++it;
-			}
+			targets.Expire(g_currentFrameTime);
+		}
+	}
+
+	// Forgets everything about the current world. Not thread-safe, only call it while the world isn't being simulated.
+	void Reset()
+	{
+		activeCollisions.clear();
+		collidedRigidbodies.clear();
+		collidedRefs.clear();
+		handCollidedRefs.clear();
+		for (int i = 0; i < 2; i++) {
+			hitCooldownTargets[i].clear();
+			collisionCooldownTargets[i].clear();
 		}
+		physicsHitCooldownTargets.clear();
+		events.Clear();
+		mergedEvents.clear();
+		world = nullptr;
 	}
 
 	NiPointer<bhkWorld> world = nullptr;
@@ -1295,116 +1167,20 @@ PlayerCharacterProxyListener g_characterProxyListener{};
 using CollisionFilterComparisonResult = HiggsPluginAPI::IHiggsInterface001::CollisionFilterComparisonResult;
 CollisionFilterComparisonResult CollisionFilterComparisonCallback(void *filter, UInt32 filterInfoA, UInt32 filterInfoB)
 {
-	UInt32 layerA = filterInfoA & 0x7f;
-	UInt32 layerB = filterInfoB & 0x7f;
-
-	if ((layerA == BGSCollisionLayer::kCollisionLayer_Biped || layerA == BGSCollisionLayer::kCollisionLayer_BipedNoCC) && (layerB == BGSCollisionLayer::kCollisionLayer_Biped || layerB == BGSCollisionLayer::kCollisionLayer_BipedNoCC)) {
-		// Biped vs. biped
-		UInt16 groupA = filterInfoA >> 16;
-		UInt16 groupB = filterInfoB >> 16;
-		if (groupA == groupB) {
-			// biped self-collision
-			if (g_selfCollidableBipedGroups.count(groupA)) {
-				return CollisionFilterComparisonResult::Continue; // will collide with all non-adjacent bones
-			}
-			else {
-				return CollisionFilterComparisonResult::Ignore;
-			}
-		}
-		else {
-			// Biped vs. another biped
-			if (Config::options.doBipedNonSelfCollision) {
-				return CollisionFilterComparisonResult::Continue;
-			}
-			else {
-				return CollisionFilterComparisonResult::Ignore;
-			}
-		}
-	}
-
-	if (layerA != BGSCollisionLayer::kCollisionLayer_CharController && layerB != BGSCollisionLayer::kCollisionLayer_CharController) {
-		// Neither collidee is a character controller
-		return CollisionFilterComparisonResult::Continue;
-	}
-
-	if (layerA == BGSCollisionLayer::kCollisionLayer_CharController && layerB == BGSCollisionLayer::kCollisionLayer_CharController) {
-		// Both collidees are character controllers. If one of them is the player, ignore the collision.
-		UInt16 groupA = filterInfoA >> 16;
-		UInt16 groupB = filterInfoB >> 16;
-		if (groupA == g_playerCollisionGroup || groupB == g_playerCollisionGroup) {
-			UInt16 otherGroup = groupA == g_playerCollisionGroup ? groupB : groupA;
-			if (g_hittableCharControllerGroups.size() > 0 && g_hittableCharControllerGroups.count(otherGroup)) {
-				// Still collide the player with hittable character controllers
-				return CollisionFilterComparisonResult::Continue;
-			}
-			return CollisionFilterComparisonResult::Ignore;
-		}
-		return CollisionFilterComparisonResult::Continue;
-	}
-
-	// One of the collidees is a character controller
-
-	UInt32 charControllerFilter = layerA == BGSCollisionLayer::kCollisionLayer_CharController ? filterInfoA : filterInfoB;
-	UInt16 group = charControllerFilter >> 16;
-	if (group != g_playerCollisionGroup) {
-		// It's not the player
-
-		UInt32 otherFilter = charControllerFilter == filterInfoA ? filterInfoB : filterInfoA;
-		UInt16 otherGroup = otherFilter >> 16;
-		if (otherGroup == g_playerCollisionGroup) {
-			// Whatever collided with the charcontroller belongs to the player
-			UInt32 otherLayer = otherFilter & 0x7f;
-			if (otherLayer == g_higgsCollisionLayer) {
-				// Higgs vs. non-player character controller
-				if (g_hittableCharControllerGroups.size() > 0 && g_hittableCharControllerGroups.count(group)) {
-					return CollisionFilterComparisonResult::Collide;
-				}
-				else {
-					return CollisionFilterComparisonResult::Ignore;
-				}
-			}
-		}
-
-		return CollisionFilterComparisonResult::Continue;
-	}
-
-	// The character controller belongs to the player
-
-	UInt32 otherFilter = charControllerFilter == filterInfoA ? filterInfoB : filterInfoA;
-	UInt32 otherLayer = otherFilter & 0x7f;
-	UInt16 otherGroup = otherFilter >> 16;
-
-	if (otherGroup != g_playerCollisionGroup) {
-		if (otherLayer == BGSCollisionLayer::kCollisionLayer_Biped || otherLayer == BGSCollisionLayer::kCollisionLayer_BipedNoCC) {
-			// Collide with the biped unless we want to explicitly ignore them
-			if (!Config::options.enablePlayerBipedCollision ||
-				(g_rightHeldObject && otherGroup == g_rightHeldCollisionGroup) ||
-				(g_leftHeldObject && otherGroup == g_leftHeldCollisionGroup)) {
-				return CollisionFilterComparisonResult::Ignore;
-			}
-
-			if (!g_activeBipedGroups.count(otherGroup)) {
-				// Disable collision with biped objects that are not actors
-				return CollisionFilterComparisonResult::Ignore;
-			}
-
-			return CollisionFilterComparisonResult::Collide;
-		}
-	}
-
-	return CollisionFilterComparisonResult::Continue;
+	UInt8 flagsA = g_collisionGroupFlags.Get(filterInfoA >> 16);
+	UInt8 flagsB = g_collisionGroupFlags.Get(filterInfoB >> 16);
+	return g_collisionFilterTable.Get(filterInfoA, filterInfoB, flagsA, flagsB);
 }
 
 void PrePhysicsStepCallback(void *world)
 {
 	// This hook is after all ragdolls' driveToPose(), and before the hkpWorld physics step
 
+	g_contactRecorder.BeginStep(g_currentFrameTime);
+
 	// At this point we can apply any impulses / velocity adjustments without fear of them being overwritten
 
-	for (auto &job : g_prePhysicsStepJobs) {
-		job.get()->Run();
-	}
-	g_prePhysicsStepJobs.clear();
+	g_prePhysicsJobs.Run();
 
 	// With the exe patched to not enable its melee collision, we still need to disable it once (after it's created)
 	for (int i = 0; i < 2; i++) {
@@ -1419,6 +1195,9 @@ void PrePhysicsStepCallback(void *world)
 			bhkWorldObject_UpdateCollisionFilter(rb);
 		}
 	}
+
+	// Bodies may have changed owner, group or hand since the last step
+	g_bodyInfoCache.Clear();
 }
 
 
@@ -1480,7 +1259,7 @@ struct NPCData
 		if (Actor_IsInRagdollState(character)) return;
 
 		if (force || g_currentFrameTime - bumpTime > Config::options.aggressionBumpCooldownTime) {
-			NiPoint3 actorToPlayer = (*g_thePlayer)->pos - character->pos;
+			NiPoint3 actorToPlayer = g_spatialIndex.playerPos - g_spatialIndex.GetPosition(character);
 			float heading = GetHeadingFromVector(actorToPlayer);
 			float bumpDirection = heading - get_vfunc<_Actor_GetHeading>(character, 0xA5)(character, false);
 			QueueBumpActor(character, bumpDirection, false, exitFurniture, false, false);
@@ -1511,7 +1290,7 @@ struct NPCData
 		PlayerCharacter *player = *g_thePlayer;
 
 		// These two are to not do aggression if they are in... certain scenes...
-		bool sharesPlayerPosition = Config::options.stopAggressionForCloseActors && VectorLength(character->pos - player->pos) < Config::options.closeActorMinDistance;
+		bool sharesPlayerPosition = Config::options.stopAggressionForCloseActors && g_spatialIndex.AreWithinDistance(character, player, Config::options.closeActorMinDistance);
 		bool isInVehicle = Config::options.stopAggressionForActorsWithVehicle && GetVehicleHandle(character) != *g_invalidRefHandle;
 		
 		if (isGrabbed || isTouched || isShoved) {
@@ -1590,7 +1369,7 @@ struct NPCData
 				accumulatedGrabbedTime = 0.f;
 				state = State::Normal;
 			}
-			else if (VectorLength(character->pos - player->pos) >= Config::options.aggressionStopCombatAlarmDistance) {
+			else if (!g_spatialIndex.AreWithinDistance(character, player, Config::options.aggressionStopCombatAlarmDistance)) {
 				// We're far enough away from the assaulted actor so make them forgive us
 				Actor_StopCombatAlarm(0, 0, player);
 				accumulatedGrabbedTime = 0.f;
@@ -1613,10 +1392,9 @@ void TryUpdateNPCState(Actor *actor, bool isShoved)
 	auto it = g_npcs.find(actor);
 	if (it == g_npcs.end()) {
 		// Not in the map yet
-		TESRace *race = actor->race;
-		if (!race) return;
-		if (!race->keyword.HasKeyword(g_keyword_actorTypeNPC)) return;
-		if (race->editorId && Config::options.aggressionExcludeRaces.count(std::string_view(race->editorId))) return;
+		UInt32 raceFlags = GetRaceFlags(actor->race);
+		if (!(raceFlags & RaceFlags::NPC)) return;
+		if (raceFlags & RaceFlags::AggressionExcluded) return;
 
 		if (Config::options.followersSkipAggression && IsTeammate(actor)) return;
 		if (RelationshipRanks::GetRelationshipRank(actor->baseForm, (*g_thePlayer)->baseForm) > Config::options.aggressionMaxRelationshipRank) return;
@@ -1629,13 +1407,81 @@ void TryUpdateNPCState(Actor *actor, bool isShoved)
 	}
 }
 
-std::unordered_map<hkbRagdollDriver *, std::shared_ptr<ActiveRagdoll>> g_activeRagdolls{};
+SlotMap<ActiveRagdoll> g_activeRagdolls{};
+std::unordered_map<hkbRagdollDriver *, SlotMap<ActiveRagdoll>::Handle> g_activeRagdollHandles{};
+
+// The returned pointer is only valid until the next active ragdoll is created or destroyed
+ActiveRagdoll * GetActiveRagdollFromDriver(hkbRagdollDriver *driver)
+{
+	auto it = g_activeRagdollHandles.find(driver);
+	if (it == g_activeRagdollHandles.end()) return nullptr;
+	return g_activeRagdolls.Get(it->second);
+}
+
+void DestroyActiveRagdoll(hkbRagdollDriver *driver)
+{
+	auto it = g_activeRagdollHandles.find(driver);
+	if (it == g_activeRagdollHandles.end()) return;
+
+	if (ActiveRagdoll *ragdoll = g_activeRagdolls.Get(it->second)) {
+		g_poseBufferPool.Release(*ragdoll);
+	}
+	g_activeRagdolls.Remove(it->second);
+	g_activeRagdollHandles.erase(it);
+}
+
+ActiveRagdoll * CreateActiveRagdoll(hkbRagdollDriver *driver)
+{
+	DestroyActiveRagdoll(driver);
+
+	SlotMap<ActiveRagdoll>::Handle handle = g_activeRagdolls.Insert(ActiveRagdoll{});
+	g_activeRagdollHandles[driver] = handle;
+	ActiveRagdoll *ragdoll = g_activeRagdolls.Get(handle);
+
+	// Reserve all pose buffers up front so nothing allocates in the physics hooks
+	hkbCharacter *character = driver->character;
+	int numPoses = character->numPoseLocal;
+	if (character->setup && character->setup->m_animationSkeleton) {
+		numPoses = std::max(numPoses, character->setup->m_animationSkeleton->m_bones.getSize());
+	}
+	int numBones = driver->ragdoll ? driver->ragdoll->getNumBones() : 0;
+	g_poseBufferPool.Acquire(*ragdoll, numPoses, numBones);
+
+	return ragdoll;
+}
+
+const Config::RagdollLodOptions & GetRagdollLodOptions(RagdollLod lod)
+{
+	switch (lod) {
+	case RagdollLod::RigidBody:
+		return Config::options.lodRigidBody;
+	case RagdollLod::Keyframed:
+		return Config::options.lodKeyframed;
+	default:
+		return Config::options.lodFull;
+	}
+}
+
+RagdollLod GetRagdollLodForDistance(float distance, RagdollLod currentLod)
+{
+	// Push out the boundaries of the tiers at or below the current one, so that an actor hovering around a boundary doesn't flip between tiers every frame
+	float hysteresis = Config::options.lodHysteresisDistance;
+	float fullMaxDistance = Config::options.lodFull.maxDistance + (currentLod == RagdollLod::Full ? hysteresis : 0.f);
+	float rigidBodyMaxDistance = Config::options.lodRigidBody.maxDistance + (currentLod != RagdollLod::Keyframed ? hysteresis : 0.f);
+
+	if (distance <= fullMaxDistance) return RagdollLod::Full;
+	if (distance <= rigidBodyMaxDistance) return RagdollLod::RigidBody;
+	return RagdollLod::Keyframed;
+}
 
-std::shared_ptr<ActiveRagdoll> GetActiveRagdollFromDriver(hkbRagdollDriver *driver)
+void UpdateRagdollLod(Actor *actor, float distance, bool isInteracting)
 {
-	auto it = g_activeRagdolls.find(driver);
-	if (it == g_activeRagdolls.end()) return nullptr;
-	return it->second;
+	ForEachRagdollDriver(actor, [distance, isInteracting](hkbRagdollDriver *driver) {
+		if (ActiveRagdoll *ragdoll = GetActiveRagdollFromDriver(driver)) {
+			// Anything the player is touching or holding needs to react properly no matter how far away it is
+			ragdoll->lod = isInteracting ? RagdollLod::Full : GetRagdollLodForDistance(distance, ragdoll->lod);
+		}
+	});
 }
 
 hkaKeyFrameHierarchyUtility::Output g_stressOut[200]; // set in a hook during driveToPose(). Just reserve a bunch of space so it can handle any number of bones.
@@ -1670,12 +1516,7 @@ bool IsAddedToWorld(Actor *actor)
 
 bool CanAddToWorld(Actor *actor)
 {
-	if (TESRace *race = actor->race) {
-		const char *name = race->editorId;
-		if (name && Config::options.excludeRaces.count(std::string_view(name))) {
-			return false;
-		}
-	}
+	if (GetRaceFlags(actor->race) & RaceFlags::Excluded) return false;
 
 	BSTSmartPointer<BSAnimationGraphManager> animGraphManager{ 0 };
 	if (!GetAnimationGraphManager(actor, animGraphManager)) return false;
@@ -1746,6 +1587,8 @@ bool AddRagdollToWorld(Actor *actor)
 {
 	if (Actor_IsInRagdollState(actor)) return false;
 
+	g_actorStateTracker.Invalidate(actor);
+
 	bool hasRagdollInterface = false;
 	BSTSmartPointer<BSAnimationGraphManager> animGraphManager{ 0 }; // need to init this to 0 or we crash
 	if (GetAnimationGraphManager(actor, animGraphManager)) {
@@ -1766,15 +1609,20 @@ bool AddRagdollToWorld(Actor *actor)
 					if (driver) {
 						g_activeActors.insert(actor);
 
-						std::shared_ptr<ActiveRagdoll> activeRagdoll(new ActiveRagdoll());
-						g_activeRagdolls[driver] = activeRagdoll;
+						ActiveRagdoll *activeRagdoll = CreateActiveRagdoll(driver);
 
 						Blender &blender = activeRagdoll->blender;
-						blender.StartBlend(Blender::BlendType::AnimToRagdoll, g_currentFrameTime, Config::options.blendInTime);
+						if (Config::options.inertializeBlendIn) {
+							// Offsets from the anim pose are recorded on the first blend frame. The offsets decay along their own curve, so blendInCurve doesn't apply.
+							blender.StartBlend(Blender::BlendType::InertializedAnimToRagdoll, g_currentFrameTime, BlendCurve(Config::options.blendInTime));
+						}
+						else {
+							blender.StartBlend(Blender::BlendType::AnimToRagdoll, g_currentFrameTime, BlendCurve(Config::options.blendInTime, Config::options.blendInCurve));
 
-						hkQsTransform *poseLocal = hkbCharacter_getPoseLocal(driver->character);
-						blender.initialPose.assign(poseLocal, poseLocal + driver->character->numPoseLocal);
-						blender.isFirstBlendFrame = false;
+							hkQsTransform *poseLocal = hkbCharacter_getPoseLocal(driver->character);
+							blender.initialPose.assign(poseLocal, poseLocal + driver->character->numPoseLocal);
+							blender.isFirstBlendFrame = false;
+						}
 
 						activeRagdoll->stateChangedTime = g_currentFrameTime;
 						activeRagdoll->state = RagdollState::BlendIn;
@@ -1817,6 +1665,8 @@ bool RemoveRagdollFromWorld(Actor *actor)
 {
 	if (Actor_IsInRagdollState(actor)) return false;
 
+	g_actorStateTracker.Invalidate(actor);
+
 	bool hasRagdollInterface = false;
 	BSTSmartPointer<BSAnimationGraphManager> animGraphManager{ 0 }; // need to init this to 0 or we crash
 	if (GetAnimationGraphManager(actor, animGraphManager)) {
@@ -1844,12 +1694,12 @@ bool RemoveRagdollFromWorld(Actor *actor)
 					BSTSmartPointer<BShkbAnimationGraph> graph = manager->graphs.GetData()[i];
 					hkbRagdollDriver *driver = graph.ptr->character.ragdollDriver;
 					if (driver) {
-						if (std::shared_ptr<ActiveRagdoll> ragdoll = GetActiveRagdollFromDriver(driver)) {
-							if (ragdoll && ragdoll->shouldNullOutWorldWhenRemovingFromWorld) {
+						if (ActiveRagdoll *ragdoll = GetActiveRagdollFromDriver(driver)) {
+							if (ragdoll->shouldNullOutWorldWhenRemovingFromWorld) {
 								graph.ptr->world = nullptr;
 							}
 						}
-						g_activeRagdolls.erase(driver);
+						DestroyActiveRagdoll(driver);
 
 						g_activeActors.erase(actor);
 					}
@@ -1951,8 +1801,8 @@ float GetSpeedReduction(Actor *actor)
 	PlayerCharacter *player = *g_thePlayer;
 
 	float massReduction = Config::options.mediumRaceSpeedReduction;
-	if (TESRace *race = actor->race) {
-		UInt32 raceSize = actor->race->data.unk40;
+	if (UInt32 raceFlags = GetRaceFlags(actor->race)) {
+		UInt32 raceSize = GetRaceSize(raceFlags);
 		if (raceSize == 0) massReduction = Config::options.smallRaceSpeedReduction;
 		if (raceSize == 2) massReduction = Config::options.largeRaceSpeedReduction;
 		if (raceSize >= 3) massReduction = Config::options.extraLargeRaceSpeedReduction;
@@ -2114,7 +1964,7 @@ bool UpdateActorShove(Actor *actor)
 	if (Config::options.disableShoveWhileWeaponsDrawn && player->actorState.IsWeaponDrawn()) return false;
 
 	for (int isLeft = 0; isLeft < 2; ++isLeft) {
-		ControllerVelocityData &velocityData = g_controllerVelocities[isLeft];
+		ControllerVelocityData<NiPoint3> &velocityData = g_controllerVelocities[isLeft];
 
 		if (velocityData.avgSpeed > Config::options.shoveSpeedThreshold) {
 			if (g_contactListener.handCollidedRefs.count(actor) && ShouldShoveActor(actor)) {
@@ -2157,14 +2007,14 @@ bool UpdateActorShove(Actor *actor)
 
 					PlayRumble(!isLeft, Config::options.shoveRumbleIntensity, Config::options.shoveRumbleDuration);
 					// Ignore future contact points for a bit to make things less janky
-					g_contactListener.collisionCooldownTargets[isLeft][actor] = g_currentFrameTime;
+					g_contactListener.collisionCooldownTargets[isLeft].Set(actor, g_currentFrameTime + Config::options.collisionCooldownTime);
 
 					if (g_controllerVelocities[!isLeft].avgSpeed > Config::options.shoveSpeedThreshold) {
 						PlayRumble(isLeft, Config::options.shoveRumbleIntensity, Config::options.shoveRumbleDuration);
-						g_contactListener.collisionCooldownTargets[!isLeft][actor] = g_currentFrameTime;
+						g_contactListener.collisionCooldownTargets[!isLeft].Set(actor, g_currentFrameTime + Config::options.collisionCooldownTime);
 					}
 
-					g_shovedActors[actor] = g_currentFrameTime;
+					g_shovedActors.Set(actor, g_currentFrameTime + Config::options.shoveCooldown);
 
 					return true;
 				}
@@ -2179,15 +2029,87 @@ void ResetObjects()
 {
 	g_npcs.clear();
 	g_activeActors.clear();
-	g_activeRagdolls.clear();
-	g_activeBipedGroups.clear();
-	g_hittableCharControllerGroups.clear();
-	g_selfCollidableBipedGroups.clear();
+	for (ActiveRagdoll &ragdoll : g_activeRagdolls) {
+		g_poseBufferPool.Release(ragdoll);
+	}
+	g_activeRagdolls.Clear();
+	g_activeRagdollHandles.clear();
+	g_collisionGroupFlags.Reset();
+	g_ragdollBudget.Clear();
+	g_spatialIndex.Clear();
+	g_actorStateTracker.Clear();
+	g_collisionFilterUpdateQueue.Clear();
+	g_raceCache.Clear();
+	g_bodyInfoCache.Clear();
 	g_higgsLingeringRigidBodies.clear();
 	g_keepOffsetActors.clear();
 	g_bumpActors.clear();
 	g_shovedActors.clear();
-	g_contactListener = ContactListener{};
+	g_contactListener.Reset();
+}
+
+// Everything the actor loop needs to know about an actor, gathered without changing any game state
+struct ActorUpdateInfo
+{
+	Actor *actor;
+	float distanceToPlayer; // havok units
+	UInt16 collisionGroup;
+	bool hasNode;
+	bool isHeld;
+	bool isTouched;
+	bool isHandTouched;
+	bool isAddedToWorld;
+	bool canAddToWorld;
+	bool canSelfCollide;
+};
+
+std::vector<ActorUpdateInfo> g_actorUpdates{};
+WorkerPool &g_actorGatherWorkers = *new WorkerPool(); // leaked on purpose, see WorkerPool
+
+// Starts, resizes or stops the gather workers to match the config, so that changing it takes effect on a config reload
+void UpdateActorGatherWorkers()
+{
+	int numWorkers = Config::options.parallelActorGather ? std::max(Config::options.actorGatherWorkerThreads, 0) : 0;
+	if (g_actorGatherWorkers.GetNumWorkers() == numWorkers) return;
+
+	if (numWorkers > 0) {
+		g_actorGatherWorkers.Start(numWorkers);
+	}
+	else {
+		g_actorGatherWorkers.Stop();
+	}
+}
+
+// May run on a worker thread, so it must only read (other than the actor's own cached state)
+void GatherActorUpdate(const SpatialIndex::Entry &entry, ActorStateTracker::State &state, ActorUpdateInfo &info)
+{
+	Actor *actor = entry.actor;
+
+	info = ActorUpdateInfo{};
+	info.actor = actor;
+	info.hasNode = actor->GetNiNode() != nullptr;
+	if (!info.hasNode) return;
+
+	info.distanceToPlayer = entry.distanceToPlayer * *g_havokWorldScale;
+	info.isHeld = actor == g_rightHeldRefr || actor == g_leftHeldRefr;
+	info.isTouched = g_contactListener.collidedRefs.count(actor);
+	info.isHandTouched = g_contactListener.handCollidedRefs.count(actor);
+
+	UInt8 rangeZone = info.distanceToPlayer < Config::options.activeRagdollStartDistance ? 0 : (info.distanceToPlayer > Config::options.activeRagdollEndDistance ? 2 : 1);
+	if (g_actorStateTracker.NeedsRefresh(state, actor, rangeZone, g_currentFrameTime)) {
+		UInt32 filterInfo; Actor_GetCollisionFilterInfo(actor, filterInfo);
+		state.collisionGroup = filterInfo >> 16;
+
+		state.isAddedToWorld = IsAddedToWorld(actor);
+		state.canAddToWorld = CanAddToWorld(actor);
+
+		state.canSelfCollide = Config::options.doBipedSelfCollision && state.collisionGroup != 0 && (GetRaceFlags(actor->race) & RaceFlags::SelfCollidable);
+	}
+
+	info.collisionGroup = state.collisionGroup;
+	info.isAddedToWorld = state.isAddedToWorld;
+	info.canAddToWorld = state.canAddToWorld;
+	info.canSelfCollide = state.canSelfCollide;
 }
 
 double g_worldChangedTime = 0.0;
@@ -2206,11 +2128,23 @@ void ProcessHavokHitJobsHook()
 	AIProcessManager *processManager = *g_aiProcessManager;
 	if (!processManager) return;
 
-	g_currentFrameTime = GetTime();
+	double now = GetTime();
+	g_currentScaledFrameTime += (now - g_currentFrameTime) * *g_globalTimeMultiplier;
+	g_currentFrameTime = now;
+
+	g_raceCache.Validate();
+
+	if (g_expiryOptionsVersion != Config::optionsVersion) {
+		// Shove cooldowns and lingering thrown objects only know the expiry time they got under the old options
+		g_shovedActors.clear();
+		g_higgsLingeringRigidBodies.clear();
+		g_expiryOptionsVersion = Config::optionsVersion;
+	}
 
 	{
 		UInt32 filterInfo; Actor_GetCollisionFilterInfo(player, filterInfo);
 		g_playerCollisionGroup = filterInfo >> 16;
+		g_collisionGroupFlags.Assign(GroupFlags::Player, &g_playerCollisionGroup, 1);
 	}
 
 	if (world != g_contactListener.world) {
@@ -2441,29 +2375,29 @@ void ProcessHavokHitJobsHook()
 		g_rightHeldRefr = g_higgsInterface->GetGrabbedObject(false);
 		g_leftHeldRefr = g_higgsInterface->GetGrabbedObject(true);
 
+		// Held objects keep lingering for a while after they're dropped / thrown
+		double lingerExpiryTime = g_currentScaledFrameTime + Config::options.thrownObjectLingerTime;
 		if (g_rightHeldObject) {
-			g_higgsLingeringRigidBodies[g_rightHeldObject] = g_currentFrameTime;
+			g_higgsLingeringRigidBodies.Set(g_rightHeldObject, lingerExpiryTime);
 		}
 		if (g_leftHeldObject) {
-			g_higgsLingeringRigidBodies[g_leftHeldObject] = g_currentFrameTime;
+			g_higgsLingeringRigidBodies.Set(g_leftHeldObject, lingerExpiryTime);
 		}
 
 		// Clear out old dropped / thrown rigidbodies
-		for (auto it = g_higgsLingeringRigidBodies.begin(); it != g_higgsLingeringRigidBodies.end();) {
-			auto[target, hitTime] = *it;
-			if ((g_currentFrameTime - hitTime) * *g_globalTimeMultiplier >= Config::options.thrownObjectLingerTime)
-				it = g_higgsLingeringRigidBodies.erase(it);
-			else
-				++it;
-		}
+		g_higgsLingeringRigidBodies.Expire(g_currentScaledFrameTime);
 	}
 
+	// The higgs layer is known now, so the contact callbacks can dispatch on it during this physics step
+	g_contactDispatchTable.Validate(g_higgsCollisionLayer);
+	g_collisionFilterTable.Validate(g_higgsCollisionLayer);
+
 	UpdateHiggsDrop();
 
 	// Do this after we've update higgs things
 	UpdateSpeedReduction();
 
-	RunDelayedJobs(g_currentFrameTime);
+	g_timerQueue.Run(g_currentFrameTime, g_currentScaledFrameTime);
 
 	{ // Ensure our listener is the last one (will be called first)
 		hkArray<hkpContactListener*> &listeners = world->world->m_contactListeners;
@@ -2481,170 +2415,227 @@ void ProcessHavokHitJobsHook()
 		}
 	}
 
-	{ // Clear out old shoved actors
-		for (auto it = g_shovedActors.begin(); it != g_shovedActors.end();) {
-			auto[actor, shovedTime] = *it;
-			if ((g_currentFrameTime - shovedTime) > Config::options.shoveCooldown)
-				it = g_shovedActors.erase(it);
-			else
-				++it;
-		}
-	}
-
-	if (g_currentFrameTime - g_worldChangedTime < Config::options.worldChangedWaitTime) return;
+	// Clear out old shoved actors
+	g_shovedActors.Expire(g_currentFrameTime);
 
+	// Snapshot the high process actors into the spatial index once, and then run everything else off of that.
+	// Actors in the high process list stay alive for the rest of this frame, so keeping raw pointers in the index is fine.
+	g_spatialIndex.Clear();
 	for (UInt32 i = 0; i < processManager->actorsHigh.count; i++) {
 		UInt32 actorHandle = processManager->actorsHigh[i];
 		NiPointer<TESObjectREFR> refr;
 		if (LookupREFRByHandle(actorHandle, refr) && refr != player) {
-			Actor *actor = DYNAMIC_CAST(refr, TESObjectREFR, Actor);
-			if (!actor || !actor->GetNiNode()) continue;
+			if (Actor *actor = DYNAMIC_CAST(refr, TESObjectREFR, Actor)) {
+				g_spatialIndex.Add(actor, actorHandle);
+			}
+		}
+	}
+	g_spatialIndex.Build(player->pos);
+
+	if (g_currentFrameTime - g_worldChangedTime < Config::options.worldChangedWaitTime) {
+		g_collisionGroupFlags.Publish(); // the filter still needs to know who the player is
+		return;
+	}
+
+	// Gather everything we need to know about each actor first without touching any game state, so that it can be spread across threads
+	int numActors = (int)g_spatialIndex.entries.size();
+	g_actorUpdates.resize(numActors);
+	g_actorStateTracker.BeginFrame(g_spatialIndex.entries);
+	UpdateActorGatherWorkers();
+	if (g_actorGatherWorkers.GetNumWorkers() > 0) {
+		g_actorGatherWorkers.ParallelFor(numActors, [](int i) { GatherActorUpdate(g_spatialIndex.entries[i], g_actorStateTracker.GetState(i), g_actorUpdates[i]); });
+	}
+	else {
+		for (int i = 0; i < numActors; i++) {
+			GatherActorUpdate(g_spatialIndex.entries[i], g_actorStateTracker.GetState(i), g_actorUpdates[i]);
+		}
+	}
 
-			bool didShove = UpdateActorShove(actor);
+	// Then apply the results serially
+	for (const ActorUpdateInfo &info : g_actorUpdates) {
+		Actor *actor = info.actor;
+		if (!info.hasNode) continue;
 
-			TryUpdateNPCState(actor, didShove);
+		bool didShove = UpdateActorShove(actor);
+
+		TryUpdateNPCState(actor, didShove);
 
 #ifdef _DEBUG
-			TESFullName *name = DYNAMIC_CAST(actor->baseForm, TESForm, TESFullName);
+		TESFullName *name = DYNAMIC_CAST(actor->baseForm, TESForm, TESFullName);
 #endif // _DEBUG
 
-			UInt32 filterInfo; Actor_GetCollisionFilterInfo(actor, filterInfo);
-			UInt16 collisionGroup = filterInfo >> 16;
+		UInt16 collisionGroup = info.collisionGroup;
 
-			bool isHeld = actor == g_rightHeldRefr || actor == g_leftHeldRefr;
-			if (isHeld) {
-				if (!Actor_IsInRagdollState(actor)) {
-					if (ShouldRagdollOnGrab(actor)) {
-						if (ActorProcessManager *process = actor->processManager) {
-							ActorProcess_PushActorAway(process, actor, player->pos, 0.f);
-						}
+		bool isHeld = info.isHeld;
+		if (isHeld) {
+			if (!Actor_IsInRagdollState(actor)) {
+				if (ShouldRagdollOnGrab(actor)) {
+					if (ActorProcessManager *process = actor->processManager) {
+						ActorProcess_PushActorAway(process, actor, player->pos, 0.f);
 					}
-					else if (ShouldKeepOffset(actor)) {
-						if (auto it = g_keepOffsetActors.find(actor); it == g_keepOffsetActors.end()) {
-							// Wasn't grabbed before
-							g_taskInterface->AddTask(KeepOffsetTask::Create(GetOrCreateRefrHandle(actor), GetOrCreateRefrHandle(player)));
-
-							// At some point we probably want to do a better job of this and use offsets from the actor itself rather than the player
-							//UInt32 handle = actorHandle;
-							//Actor_KeepOffsetFromActor(actor, handle, NiPoint3(0.f, 100.f, 0.f), NiPoint3(0.f, 0.f, 0.f), 150.f, 0.f);
+				}
+				else if (ShouldKeepOffset(actor)) {
+					if (auto it = g_keepOffsetActors.find(actor); it == g_keepOffsetActors.end()) {
+						// Wasn't grabbed before
+						g_taskInterface->AddTask(KeepOffsetTask::Create(GetOrCreateRefrHandle(actor), GetOrCreateRefrHandle(player)));
 
-							g_keepOffsetActors[actor] = { g_currentFrameTime, false };
-						}
-						else {
-							// Already in the set, so check if it actually succeeded at first
-							KeepOffsetData &data = it->second;
+						// At some point we probably want to do a better job of this and use offsets from the actor itself rather than the player
+						//UInt32 handle = actorHandle;
+						//Actor_KeepOffsetFromActor(actor, handle, NiPoint3(0.f, 100.f, 0.f), NiPoint3(0.f, 0.f, 0.f), 150.f, 0.f);
 
-							if (GetMovementController(actor) && !HasKeepOffsetInterface(actor)) {
-								if (g_currentFrameTime - data.lastAttemptTime > Config::options.keepOffsetRetryInterval) {
-									// Retry
+						g_keepOffsetActors[actor] = { g_currentFrameTime, false };
+					}
+					else {
+						// Already in the set, so check if it actually succeeded at first
+						KeepOffsetData &data = it->second;
 
-									if (Config::options.bumpActorIfKeepOffsetFails) {
-										// Try to get them unstuck by bumping them
-										QueueBumpActor(actor, 0.f, false, false, false, false);
-									}
+						if (GetMovementController(actor) && !HasKeepOffsetInterface(actor)) {
+							if (g_currentFrameTime - data.lastAttemptTime > Config::options.keepOffsetRetryInterval) {
+								// Retry
 
-									g_taskInterface->AddTask(KeepOffsetTask::Create(GetOrCreateRefrHandle(actor), GetOrCreateRefrHandle(player)));
-									data.lastAttemptTime = g_currentFrameTime;
+								if (Config::options.bumpActorIfKeepOffsetFails) {
+									// Try to get them unstuck by bumping them
+									QueueBumpActor(actor, 0.f, false, false, false, false);
 								}
-							}
-							else if (!data.success) {
-								// To be sure, do a single additional attempt once we know the interface exists
+
 								g_taskInterface->AddTask(KeepOffsetTask::Create(GetOrCreateRefrHandle(actor), GetOrCreateRefrHandle(player)));
-								data.success = true;
+								data.lastAttemptTime = g_currentFrameTime;
 							}
 						}
+						else if (!data.success) {
+							// To be sure, do a single additional attempt once we know the interface exists
+							g_taskInterface->AddTask(KeepOffsetTask::Create(GetOrCreateRefrHandle(actor), GetOrCreateRefrHandle(player)));
+							data.success = true;
+						}
 					}
 				}
+			}
 
-				// When an npc is grabbed, disable collision with them
-				if (actor == g_rightHeldRefr) {
-					g_rightHeldCollisionGroup = collisionGroup;
-				}
-				if (actor == g_leftHeldRefr) {
-					g_leftHeldCollisionGroup = collisionGroup;
-				}
+			// When an npc is grabbed, disable collision with them
+			if (actor == g_rightHeldRefr) {
+				g_rightHeldCollisionGroup = collisionGroup;
 			}
-			else {
-				if (g_keepOffsetActors.size() > 0 && g_keepOffsetActors.count(actor)) {
-					Actor_ClearKeepOffsetFromActor(actor);
-					g_keepOffsetActors.erase(actor);
-				}
+			if (actor == g_leftHeldRefr) {
+				g_leftHeldCollisionGroup = collisionGroup;
+			}
+		}
+		else {
+			if (g_keepOffsetActors.size() > 0 && g_keepOffsetActors.count(actor)) {
+				Actor_ClearKeepOffsetFromActor(actor);
+				g_keepOffsetActors.erase(actor);
 			}
+		}
 
-			bool isHittableCharController = g_hittableCharControllerGroups.size() > 0 && g_hittableCharControllerGroups.count(collisionGroup);
+		bool isHittableCharController = g_collisionGroupFlags.GetStaged(collisionGroup) & GroupFlags::Hittable;
 
-			bool shouldAddToWorld = VectorLength(actor->pos - player->pos) * *g_havokWorldScale < Config::options.activeRagdollStartDistance;
-			bool shouldRemoveFromWorld = VectorLength(actor->pos - player->pos) * *g_havokWorldScale > Config::options.activeRagdollEndDistance;
+		float distanceToPlayer = info.distanceToPlayer;
+		bool shouldAddToWorld = distanceToPlayer < Config::options.activeRagdollStartDistance;
+		bool shouldRemoveFromWorld = distanceToPlayer > Config::options.activeRagdollEndDistance;
 
-			bool isAddedToWorld = IsAddedToWorld(actor);
-			bool isActiveActor = g_activeActors.count(actor);
-			bool isProcessedActor = isActiveActor || isHittableCharController;
-			bool canAddToWorld = CanAddToWorld(actor);
-			
-			if (shouldAddToWorld) {
-				if ((!isAddedToWorld || !isProcessedActor) && canAddToWorld) {
-					AddRagdollToWorld(actor);
-					if (collisionGroup != 0) {
-						g_activeBipedGroups.insert(collisionGroup);
-					}
+		bool isAddedToWorld = info.isAddedToWorld;
+		bool isActiveActor = g_activeActors.count(actor);
+		bool canAddToWorld = info.canAddToWorld;
+
+		bool isInteracting = isHeld || info.isTouched || info.isHandTouched || g_keepOffsetActors.count(actor);
+
+		if (canAddToWorld && (shouldAddToWorld || (isActiveActor && !shouldRemoveFromWorld))) {
+			g_ragdollBudget.AddCandidate(actor, distanceToPlayer, isInteracting, isActiveActor);
+		}
+		else if (isActiveActor) {
+			g_ragdollBudget.KeepActive(actor);
+		}
+
+		bool isAllowedByBudget = g_ragdollBudget.IsAllowed(actor);
+		if (isActiveActor && !isAllowedByBudget && isAddedToWorld && canAddToWorld) {
+			// Lost its slot to a higher priority actor
+			if (RemoveRagdollFromWorld(actor)) {
+				g_collisionGroupFlags.Remove(collisionGroup, GroupFlags::ActiveBiped);
+				isActiveActor = g_activeActors.count(actor);
+				isAddedToWorld = IsAddedToWorld(actor);
+			}
+		}
+
+		bool isProcessedActor = isActiveActor || isHittableCharController;
+		
+		if (shouldAddToWorld) {
+			if ((!isAddedToWorld || !isProcessedActor) && canAddToWorld && isAllowedByBudget) {
+				AddRagdollToWorld(actor);
+				if (collisionGroup != 0) {
+					g_collisionGroupFlags.Add(collisionGroup, GroupFlags::ActiveBiped);
 				}
+			}
 
-				if (!canAddToWorld) {
-					// There is no ragdoll instance, but we still need a way to hit the enemy, e.g. for the wisp (witchlight).
-					// In this case, we need to register collisions against their charcontroller.
-					if (collisionGroup != 0) {
-						g_hittableCharControllerGroups.insert(collisionGroup);
-					}
+			if (!canAddToWorld) {
+				// There is no ragdoll instance, but we still need a way to hit the enemy, e.g. for the wisp (witchlight).
+				// In this case, we need to register collisions against their charcontroller.
+				if (collisionGroup != 0) {
+					g_collisionGroupFlags.Add(collisionGroup, GroupFlags::Hittable);
 				}
+			}
 
-				if (isActiveActor) {
-					if (collisionGroup != 0) {
-						g_activeBipedGroups.insert(collisionGroup);
-					}
+			if (isActiveActor) {
+				if (collisionGroup != 0) {
+					g_collisionGroupFlags.Add(collisionGroup, GroupFlags::ActiveBiped);
+				}
 
-					// Sometimes the game re-enables sync-on-update e.g. when switching outfits, so we need to make sure it's disabled.
-					DisableSyncOnUpdate(actor);
+				// Sometimes the game re-enables sync-on-update e.g. when switching outfits, so we need to make sure it's disabled.
+				DisableSyncOnUpdate(actor);
 
-					if (Config::options.forceAnimationUpdateForActiveActors) {
-						// Force the game to run the animation graph update (and hence driveToPose, etc.)
-						actor->flags2 |= (1 << 8);
-					}
+				if (Config::options.forceAnimationUpdateForActiveActors) {
+					// Force the game to run the animation graph update (and hence driveToPose, etc.)
+					actor->flags2 |= (1 << 8);
+				}
 
-					// Set whether we want biped self-collision for this actor
-					if (Config::options.doBipedSelfCollision && collisionGroup != 0) {
-						if (TESRace *race = actor->race) {
-							const char *name = race->editorId;
-							if ((Config::options.doBipedSelfCollisionForNPCs && race->keyword.HasKeyword(g_keyword_actorTypeNPC)) ||
-								(name && Config::options.additionalSelfCollisionRaces.count(std::string_view(name)))) {
-
-								if (g_contactListener.collidedRefs.count(actor) || isHeld) {
-									if (!g_selfCollidableBipedGroups.count(collisionGroup)) {
-										g_selfCollidableBipedGroups.insert(collisionGroup);
-										UpdateCollisionFilterOnAllBones(actor);
-									}
-								}
-								else {
-									if (g_selfCollidableBipedGroups.count(collisionGroup)) {
-										g_selfCollidableBipedGroups.erase(collisionGroup);
-										UpdateCollisionFilterOnAllBones(actor);
-									}
-								}
-							}
+				// Set whether we want biped self-collision for this actor
+				if (info.canSelfCollide) {
+					if (info.isTouched || isHeld) {
+						if (!(g_collisionGroupFlags.GetStaged(collisionGroup) & GroupFlags::SelfCollidable)) {
+							g_collisionGroupFlags.Add(collisionGroup, GroupFlags::SelfCollidable);
+							// New collisions between the bones need to be found
+							UpdateCollisionFilterOnAllBones(actor, HK_UPDATE_FILTER_ON_ENTITY_FULL_CHECK);
+						}
+					}
+					else {
+						if (g_collisionGroupFlags.GetStaged(collisionGroup) & GroupFlags::SelfCollidable) {
+							g_collisionGroupFlags.Remove(collisionGroup, GroupFlags::SelfCollidable);
+							// Only need to drop the collisions between the bones that are now filtered out
+							UpdateCollisionFilterOnAllBones(actor, HK_UPDATE_FILTER_ON_ENTITY_DISABLE_ENTITY_ENTITY_COLLISIONS_ONLY);
 						}
 					}
 				}
 			}
-			else if (shouldRemoveFromWorld) {
-				if (isAddedToWorld && canAddToWorld) {
-					RemoveRagdollFromWorld(actor);
-					g_activeBipedGroups.erase(collisionGroup);
-				}
-				else if (isHittableCharController) {
-					g_hittableCharControllerGroups.erase(collisionGroup);
-				}
+		}
+		else if (shouldRemoveFromWorld) {
+			if (isAddedToWorld && canAddToWorld) {
+				RemoveRagdollFromWorld(actor);
+				g_collisionGroupFlags.Remove(collisionGroup, GroupFlags::ActiveBiped);
+			}
+			else if (isHittableCharController) {
+				g_collisionGroupFlags.Remove(collisionGroup, GroupFlags::Hittable);
 			}
 		}
+
+		if (g_activeActors.count(actor)) {
+			UpdateRagdollLod(actor, distanceToPlayer, isInteracting);
+		}
+	}
+
+	{ // Held actors don't collide with the player
+		UInt16 heldGroups[2];
+		int numHeldGroups = 0;
+		if (g_rightHeldObject) heldGroups[numHeldGroups++] = g_rightHeldCollisionGroup;
+		if (g_leftHeldObject) heldGroups[numHeldGroups++] = g_leftHeldCollisionGroup;
+		g_collisionGroupFlags.Assign(GroupFlags::Held, heldGroups, numHeldGroups);
 	}
+
+	// The filter has to see this frame's group changes before the refreshes below run it again
+	g_collisionGroupFlags.Publish();
+
+	// All the filter changes from this frame in one go, before the physics step
+	g_collisionFilterUpdateQueue.Flush();
+
+	// Decides who gets a ragdoll next frame
+	g_ragdollBudget.Resolve(g_currentFrameTime);
 }
 
 void TryForceRigidBodyControls(hkbGeneratorOutput &output, hkbGeneratorOutput::TrackHeader &header)
@@ -2730,7 +2721,7 @@ void PreDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCon
 	hkbGeneratorOutput::TrackHeader *rigidBodyHeader = GetTrackHeader(generatorOutput, hkbGeneratorOutput::StandardTracks::TRACK_RIGID_BODY_RAGDOLL_CONTROLS);
 	hkbGeneratorOutput::TrackHeader *poweredHeader = GetTrackHeader(generatorOutput, hkbGeneratorOutput::StandardTracks::TRACK_POWERED_RAGDOLL_CONTROLS);
 
-	std::shared_ptr<ActiveRagdoll> ragdoll = GetActiveRagdollFromDriver(driver);
+	ActiveRagdoll *ragdoll = GetActiveRagdollFromDriver(driver);
 	if (!ragdoll) return;
 
 	ragdoll->deltaTime = deltaTime;
@@ -2739,7 +2730,7 @@ void PreDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCon
 	if (Config::options.blendWhenGettingUp) {
 		if (ragdoll->knockState == KnockState::BeginGetUp && knockState == KnockState::GetUp) {
 			// Went from starting to get up to actually getting up
-			ragdoll->blender.StartBlend(Blender::BlendType::RagdollToCurrentRagdoll, g_currentFrameTime, Config::options.getUpBlendTime);
+			ragdoll->blender.StartBlend(Blender::BlendType::RagdollToCurrentRagdoll, g_currentFrameTime, BlendCurve(Config::options.getUpBlendTime, Config::options.getUpBlendCurve));
 		}
 	}
 	ragdoll->knockState = knockState;
@@ -2752,6 +2743,8 @@ void PreDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCon
 
 	if (Actor_IsInRagdollState(actor) || IsActorGettingUp(actor)) return;
 
+	const Config::RagdollLodOptions &lodOptions = GetRagdollLodOptions(ragdoll->lod);
+
 	bool isRigidBodyOn = rigidBodyHeader && rigidBodyHeader->m_onFraction > 0.f;
 	bool isPoweredOn = poweredHeader && poweredHeader->m_onFraction > 0.f;
 
@@ -2763,7 +2756,7 @@ void PreDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCon
 		}
 	}
 
-	if (isRigidBodyOn && !isPoweredOn) {
+	if (isRigidBodyOn && !isPoweredOn && lodOptions.usePoweredController) {
 		if (poweredHeader) {
 			TryForcePoweredControls(generatorOutput, *poweredHeader);
 			isPoweredOn = poweredHeader->m_onFraction > 0.f;
@@ -2781,7 +2774,12 @@ void PreDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCon
 		return;
 	}
 
-	if (Config::options.enableKeyframes) {
+	if (lodOptions.keyframed) {
+		if (keyframedBonesHeader && keyframedBonesHeader->m_onFraction > 0.f) {
+			SetBonesKeyframedReporting(driver, generatorOutput, *keyframedBonesHeader);
+		}
+	}
+	else if (Config::options.enableKeyframes) {
 		double elapsedTime = (g_currentFrameTime - ragdoll->stateChangedTime) * *g_globalTimeMultiplier;
 		if (elapsedTime <= Config::options.blendInKeyframeTime) {
 			if (keyframedBonesHeader && keyframedBonesHeader->m_onFraction > 0.f) {
@@ -2829,7 +2827,7 @@ void PreDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCon
 		}
 	}
 
-	if (Config::options.loosenRagdollContraintsToMatchPose) {
+	if (Config::options.loosenRagdollContraintsToMatchPose && lodOptions.loosenConstraints) {
 		if (poseHeader && poseHeader->m_onFraction > 0.f && worldFromModelHeader && worldFromModelHeader->m_onFraction > 0.f) {
 			hkQsTransform &worldFromModel = *(hkQsTransform *)Track_getData(generatorOutput, *worldFromModelHeader);
 			hkQsTransform *poseLocal = (hkQsTransform *)Track_getData(generatorOutput, *poseHeader);
@@ -2870,7 +2868,7 @@ void PreDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCon
 		}
 	}
 
-	if (Config::options.disableGravityForActiveRagdolls) {
+	if (Config::options.disableGravityForActiveRagdolls && lodOptions.disableGravity) {
 		for (int i = 0; i < driver->ragdoll->m_rigidBodies.getSize(); i++) {
 			hkpRigidBody *rigidBody = driver->ragdoll->m_rigidBodies[i];
 			rigidBody->setGravityFactor(0.f);
@@ -2945,7 +2943,7 @@ void PostDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCo
 	Actor *actor = GetActorFromRagdollDriver(driver);
 	if (!actor) return;
 
-	std::shared_ptr<ActiveRagdoll> ragdoll = GetActiveRagdollFromDriver(driver);
+	ActiveRagdoll *ragdoll = GetActiveRagdollFromDriver(driver);
 	if (!ragdoll) return;
 
 	if (!ragdoll->isOn) return;
@@ -2954,14 +2952,19 @@ void PostDriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbCo
 	if (numBones <= 0) return;
 	ragdoll->stress.clear();
 
-	float totalStress = 0.f;
-	for (int i = 0; i < numBones; i++) {
-		float stress = sqrtf(g_stressOut[i].m_stressSquared);
-		ragdoll->stress.push_back(stress);
-		totalStress += stress;
-	}
+	if (GetRagdollLodOptions(ragdoll->lod).readStress) {
+		float totalStress = 0.f;
+		for (int i = 0; i < numBones; i++) {
+			float stress = sqrtf(g_stressOut[i].m_stressSquared);
+			ragdoll->stress.push_back(stress);
+			totalStress += stress;
+		}
 
-	ragdoll->avgStress = totalStress / numBones;
+		ragdoll->avgStress = totalStress / numBones;
+	}
+	else {
+		ragdoll->avgStress = 0.f;
+	}
 	//_MESSAGE("stress: %.2f", avgStress);
 	//PrintToFile(std::to_string(ragdoll->avgStress), "stress.txt");
 
@@ -2981,7 +2984,7 @@ void PrePostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hkb
 
 	// All we're doing here is storing the anim pose, so it's fine to run this even if the actor is fully ragdolled or getting up.
 
-	std::shared_ptr<ActiveRagdoll> ragdoll = GetActiveRagdollFromDriver(driver);
+	ActiveRagdoll *ragdoll = GetActiveRagdollFromDriver(driver);
 	if (!ragdoll) return;
 
 	if (!ragdoll->isOn) return;
@@ -2990,8 +2993,12 @@ void PrePostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hkb
 	if (poseHeader && poseHeader->m_onFraction > 0.f) {
 		int numPoses = poseHeader->m_numData;
 		hkQsTransform *animPose = (hkQsTransform *)Track_getData(inOut, *poseHeader);
-		// Copy anim pose track before postPhysics() as postPhysics() will overwrite it with the ragdoll pose
+		// Copy anim pose track before postPhysics() as postPhysics() will overwrite it with the ragdoll pose.
+		// Last frame's pose is kept by swapping the buffers, not copying them.
+		std::swap(ragdoll->previousAnimPose, ragdoll->animPose);
+		ragdoll->previousAnimPoseTime = ragdoll->animPoseTime;
 		ragdoll->animPose.assign(animPose, animPose + numPoses);
+		ragdoll->animPoseTime = g_currentFrameTime;
 	}
 }
 
@@ -3004,7 +3011,7 @@ void PostPostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hk
 
 	// All we're doing here is storing the ragdoll pose and blending, and we do want to have the option to blend even while getting up.
 
-	std::shared_ptr<ActiveRagdoll> ragdoll = GetActiveRagdollFromDriver(driver);
+	ActiveRagdoll *ragdoll = GetActiveRagdollFromDriver(driver);
 	if (!ragdoll) return;
 
 	if (!ragdoll->isOn) return;
@@ -3024,7 +3031,7 @@ void PostPostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hk
 		}
 	}
 
-	if (Config::options.disableGravityForActiveRagdolls) {
+	if (Config::options.disableGravityForActiveRagdolls && GetRagdollLodOptions(ragdoll->lod).disableGravity) {
 		for (int i = 0; i < driver->ragdoll->m_rigidBodies.getSize(); i++) {
 			hkpRigidBody *rigidBody = driver->ragdoll->m_rigidBodies[i];
 			rigidBody->setGravityFactor(1.f);
@@ -3036,7 +3043,10 @@ void PostPostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hk
 		hkQsTransform *poseOut = (hkQsTransform *)Track_getData(inOut, *poseHeader);
 
 		// Copy pose track now since postPhysics() just set it to the high-res ragdoll pose
+		std::swap(ragdoll->previousRagdollPose, ragdoll->ragdollPose);
+		ragdoll->previousRagdollPoseTime = ragdoll->ragdollPoseTime;
 		ragdoll->ragdollPose.assign(poseOut, poseOut + numPoses);
+		ragdoll->ragdollPoseTime = g_currentFrameTime;
 	}
 
 	Blender &blender = ragdoll->blender;
@@ -3059,14 +3069,14 @@ void PostPostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hk
 		if (poseHeader && poseHeader->m_onFraction > 0.f) {
 			int numPoses = poseHeader->m_numData;
 			hkQsTransform *poseOut = (hkQsTransform *)Track_getData(inOut, *poseHeader);
-			memcpy(poseOut, ragdoll->animPose.data(), numPoses * sizeof(hkQsTransform));
+			memcpy(poseOut, ragdoll->animPose.data(), std::min(numPoses, ragdoll->animPose.size()) * sizeof(hkQsTransform));
 		}
 	}
 	else if (Config::options.forceRagdollPose) {
 		if (poseHeader && poseHeader->m_onFraction > 0.f) {
 			int numPoses = poseHeader->m_numData;
 			hkQsTransform *poseOut = (hkQsTransform *)Track_getData(inOut, *poseHeader);
-			memcpy(poseOut, ragdoll->ragdollPose.data(), numPoses * sizeof(hkQsTransform));
+			memcpy(poseOut, ragdoll->ragdollPose.data(), std::min(numPoses, ragdoll->ragdollPose.size()) * sizeof(hkQsTransform));
 		}
 	}
 
@@ -3075,16 +3085,30 @@ void PostPostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hk
 
 void DriveToPoseHook(hkbRagdollDriver *driver, hkReal deltaTime, const hkbContext& context, hkbGeneratorOutput& generatorOutput)
 {
+	bool isActive = GetActiveRagdollFromDriver(driver);
+	double startTime = isActive ? GetTime() : 0.0;
+
 	PreDriveToPoseHook(driver, deltaTime, context, generatorOutput);
 	hkbRagdollDriver_driveToPose(driver, deltaTime, context, generatorOutput);
 	PostDriveToPoseHook(driver, deltaTime, context, generatorOutput);
+
+	if (isActive) {
+		g_ragdollBudget.AddCost(GetTime() - startTime);
+	}
 }
 
 void PostPhysicsHook(hkbRagdollDriver *driver, const hkbContext &context, hkbGeneratorOutput &inOut)
 {
+	bool isActive = GetActiveRagdollFromDriver(driver);
+	double startTime = isActive ? GetTime() : 0.0;
+
 	PrePostPhysicsHook(driver, context, inOut);
 	hkbRagdollDriver_postPhysics(driver, context, inOut);
 	PostPostPhysicsHook(driver, context, inOut);
+
+	if (isActive) {
+		g_ragdollBudget.AddCost(GetTime() - startTime);
+	}
 }
 
 void PreCullActorsHook(Actor *actor)
@@ -3472,6 +3496,19 @@ bool TryHook()
 	return true;
 }
 
+void RecordControllerSample(bool isLeft, const NiPoint3 &velocity)
+{
+	if (!g_contactRecorder.IsRecording()) return;
+
+	const ControllerVelocityData<NiPoint3> &data = g_controllerVelocities[isLeft];
+	g_contactRecorder.RecordControllerSample({
+		GetTime(), isLeft,
+		{ velocity.x, velocity.y, velocity.z },
+		{ data.avgVelocity.x, data.avgVelocity.y, data.avgVelocity.z },
+		data.avgSpeed
+	});
+}
+
 bool WaitPosesCB(vr_src::TrackedDevicePose_t* pRenderPoseArray, uint32_t unRenderPoseArrayCount, vr_src::TrackedDevicePose_t* pGamePoseArray, uint32_t unGamePoseArrayCount)
 {
 	PlayerCharacter *player = *g_thePlayer;
@@ -3524,9 +3561,8 @@ bool WaitPosesCB(vr_src::TrackedDevicePose_t* pRenderPoseArray, uint32_t unRende
 								NiPoint3 openvrVelocity = { pose.vVelocity.v[0], pose.vVelocity.v[1], pose.vVelocity.v[2] };
 								NiPoint3 skyrimVelocity = { openvrVelocity.x, -openvrVelocity.z, openvrVelocity.y };
 								NiPoint3 velocityWorldspace = openvrToSkyrimWorldTransform * skyrimVelocity;
-								g_controllerVelocities[0].velocities.pop_back();
-								g_controllerVelocities[0].velocities.push_front(velocityWorldspace);
-								g_controllerVelocities[0].Recompute();
+								g_controllerVelocities[0].Add(velocityWorldspace);
+								RecordControllerSample(false, velocityWorldspace);
 							}
 						}
 						else if (i == leftIndex && isLeftConnected) {
@@ -3535,9 +3571,8 @@ bool WaitPosesCB(vr_src::TrackedDevicePose_t* pRenderPoseArray, uint32_t unRende
 								NiPoint3 openvrVelocity = { pose.vVelocity.v[0], pose.vVelocity.v[1], pose.vVelocity.v[2] };
 								NiPoint3 skyrimVelocity = { openvrVelocity.x, -openvrVelocity.z, openvrVelocity.y };
 								NiPoint3 velocityWorldspace = openvrToSkyrimWorldTransform * skyrimVelocity;
-								g_controllerVelocities[1].velocities.pop_back();
-								g_controllerVelocities[1].velocities.push_front(velocityWorldspace);
-								g_controllerVelocities[1].Recompute();
+								g_controllerVelocities[1].Add(velocityWorldspace);
+								RecordControllerSample(true, velocityWorldspace);
 							}
 						}
 					}
@@ -3609,6 +3644,9 @@ extern "C" {
 			return;
 		}
 
+		// Anything cached before now was computed without the keywords
+		g_raceCache.Clear();
+
 		_MESSAGE("Successfully loaded all forms");
 	}
 
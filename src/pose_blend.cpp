@@ -0,0 +1,347 @@
+#include <cmath>
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#include <cpuid.h>
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
+#include "pose_blend.h"
+
+
+// hkQsTransform is translation, rotation, scale, each 4 floats
+static_assert(sizeof(hkQsTransform) == 12 * sizeof(float), "Unexpected hkQsTransform layout");
+static constexpr int g_floatsPerPose = 12;
+static constexpr int g_translationOffset = 0;
+static constexpr int g_rotationOffset = 4;
+static constexpr int g_scaleOffset = 8;
+
+// Blended rotations shorter than this (e.g. from zero quaternions in a pose) come out as zero instead of being normalized, the same in every kernel.
+// Below it, rsqrt would give inf and inf * 0 = nan.
+static constexpr float g_minRotationLengthSquared = 1e-12f;
+
+
+static void BlendPosePortable(const float *src, const float *dst, float *out, float weight)
+{
+	float translation[4];
+	float rotation[4];
+	float scale[4];
+
+	float dot = 0.f;
+	for (int i = 0; i < 4; i++) {
+		dot += src[g_rotationOffset + i] * dst[g_rotationOffset + i];
+	}
+	float sign = dot < 0.f ? -1.f : 1.f;
+
+	float lengthSquared = 0.f;
+	for (int i = 0; i < 4; i++) {
+		translation[i] = src[g_translationOffset + i] + (dst[g_translationOffset + i] - src[g_translationOffset + i]) * weight;
+		rotation[i] = src[g_rotationOffset + i] + (sign * dst[g_rotationOffset + i] - src[g_rotationOffset + i]) * weight;
+		scale[i] = src[g_scaleOffset + i] + (dst[g_scaleOffset + i] - src[g_scaleOffset + i]) * weight;
+		lengthSquared += rotation[i] * rotation[i];
+	}
+
+	float invLength = lengthSquared > g_minRotationLengthSquared ? 1.f / sqrtf(lengthSquared) : 0.f;
+	for (int i = 0; i < 4; i++) {
+		out[g_translationOffset + i] = translation[i];
+		out[g_rotationOffset + i] = rotation[i] * invLength;
+		out[g_scaleOffset + i] = scale[i];
+	}
+}
+
+static void BlendPosesPortable(const float *src, const float *dst, float *out, const float *weights, float weight, int numPoses)
+{
+	for (int i = 0; i < numPoses; i++) {
+		int offset = i * g_floatsPerPose;
+		BlendPosePortable(src + offset, dst + offset, out + offset, weights ? weights[i] : weight);
+	}
+}
+
+
+// Loads one component (translation/rotation/scale) of 4 consecutive bones and transposes them into xxxx, yyyy, zzzz, wwww
+static inline void LoadSoA4(const float *poses, int componentOffset, __m128 &x, __m128 &y, __m128 &z, __m128 &w)
+{
+	x = _mm_loadu_ps(poses + 0 * g_floatsPerPose + componentOffset);
+	y = _mm_loadu_ps(poses + 1 * g_floatsPerPose + componentOffset);
+	z = _mm_loadu_ps(poses + 2 * g_floatsPerPose + componentOffset);
+	w = _mm_loadu_ps(poses + 3 * g_floatsPerPose + componentOffset);
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+}
+
+static inline void StoreSoA4(float *poses, int componentOffset, __m128 x, __m128 y, __m128 z, __m128 w)
+{
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(poses + 0 * g_floatsPerPose + componentOffset, x);
+	_mm_storeu_ps(poses + 1 * g_floatsPerPose + componentOffset, y);
+	_mm_storeu_ps(poses + 2 * g_floatsPerPose + componentOffset, z);
+	_mm_storeu_ps(poses + 3 * g_floatsPerPose + componentOffset, w);
+}
+
+static inline __m128 Lerp4(__m128 a, __m128 b, __m128 t)
+{
+	return _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+}
+
+static inline void LerpComponent4(const float *src, const float *dst, float *out, int componentOffset, __m128 t)
+{
+	__m128 ax, ay, az, aw, bx, by, bz, bw;
+	LoadSoA4(src, componentOffset, ax, ay, az, aw);
+	LoadSoA4(dst, componentOffset, bx, by, bz, bw);
+	StoreSoA4(out, componentOffset, Lerp4(ax, bx, t), Lerp4(ay, by, t), Lerp4(az, bz, t), Lerp4(aw, bw, t));
+}
+
+static void BlendPosesSSE(const float *src, const float *dst, float *out, const float *weights, float weight, int numPoses)
+{
+	const __m128 signBit = _mm_set1_ps(-0.f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 threeHalves = _mm_set1_ps(1.5f);
+	const __m128 uniformWeight = _mm_set1_ps(weight);
+	const __m128 minLengthSquared = _mm_set1_ps(g_minRotationLengthSquared);
+
+	int i = 0;
+	for (; i + 4 <= numPoses; i += 4) {
+		int offset = i * g_floatsPerPose;
+		const float *a = src + offset;
+		const float *b = dst + offset;
+		float *o = out + offset;
+
+		__m128 t = weights ? _mm_loadu_ps(weights + i) : uniformWeight;
+
+		// Rotations go first since out may alias src or dst, and each component is fully loaded before it is stored
+		__m128 ax, ay, az, aw, bx, by, bz, bw;
+		LoadSoA4(a, g_rotationOffset, ax, ay, az, aw);
+		LoadSoA4(b, g_rotationOffset, bx, by, bz, bw);
+
+		// Flip dst where the quaternions are in opposite hemispheres
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+		__m128 flip = _mm_and_ps(dot, signBit);
+		bx = _mm_xor_ps(bx, flip);
+		by = _mm_xor_ps(by, flip);
+		bz = _mm_xor_ps(bz, flip);
+		bw = _mm_xor_ps(bw, flip);
+
+		__m128 qx = Lerp4(ax, bx, t);
+		__m128 qy = Lerp4(ay, by, t);
+		__m128 qz = Lerp4(az, bz, t);
+		__m128 qw = Lerp4(aw, bw, t);
+
+		// Normalize with rsqrt + one newton-raphson step, and zero the lanes that are too short to normalize like the portable kernel does
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+		__m128 r = _mm_rsqrt_ps(lengthSquared);
+		r = _mm_mul_ps(r, _mm_sub_ps(threeHalves, _mm_mul_ps(_mm_mul_ps(half, lengthSquared), _mm_mul_ps(r, r))));
+		r = _mm_and_ps(r, _mm_cmpgt_ps(lengthSquared, minLengthSquared));
+
+		StoreSoA4(o, g_rotationOffset, _mm_mul_ps(qx, r), _mm_mul_ps(qy, r), _mm_mul_ps(qz, r), _mm_mul_ps(qw, r));
+
+		LerpComponent4(a, b, o, g_translationOffset, t);
+		LerpComponent4(a, b, o, g_scaleOffset, t);
+	}
+
+	int offset = i * g_floatsPerPose;
+	BlendPosesPortable(src + offset, dst + offset, out + offset, weights ? weights + i : nullptr, weight, numPoses - i);
+}
+
+
+// The 8-wide kernel keeps bones i..i+3 in the low 128-bit lane and bones i+4..i+7 in the high lane, so the 4x4 transpose happens per lane
+AVX2_TARGET static inline void LoadSoA8(const float *poses, int componentOffset, __m256 &x, __m256 &y, __m256 &z, __m256 &w)
+{
+	__m256 r0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(poses + 0 * g_floatsPerPose + componentOffset)), _mm_loadu_ps(poses + 4 * g_floatsPerPose + componentOffset), 1);
+	__m256 r1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(poses + 1 * g_floatsPerPose + componentOffset)), _mm_loadu_ps(poses + 5 * g_floatsPerPose + componentOffset), 1);
+	__m256 r2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(poses + 2 * g_floatsPerPose + componentOffset)), _mm_loadu_ps(poses + 6 * g_floatsPerPose + componentOffset), 1);
+	__m256 r3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(poses + 3 * g_floatsPerPose + componentOffset)), _mm_loadu_ps(poses + 7 * g_floatsPerPose + componentOffset), 1);
+
+	__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+	__m256 t1 = _mm256_unpackhi_ps(r0, r1);
+	__m256 t2 = _mm256_unpacklo_ps(r2, r3);
+	__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+
+	x = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	y = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	z = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	w = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+AVX2_TARGET static inline void StoreSoA8(float *poses, int componentOffset, __m256 x, __m256 y, __m256 z, __m256 w)
+{
+	__m256 t0 = _mm256_unpacklo_ps(x, y);
+	__m256 t1 = _mm256_unpackhi_ps(x, y);
+	__m256 t2 = _mm256_unpacklo_ps(z, w);
+	__m256 t3 = _mm256_unpackhi_ps(z, w);
+
+	__m256 r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+	_mm_storeu_ps(poses + 0 * g_floatsPerPose + componentOffset, _mm256_castps256_ps128(r0));
+	_mm_storeu_ps(poses + 1 * g_floatsPerPose + componentOffset, _mm256_castps256_ps128(r1));
+	_mm_storeu_ps(poses + 2 * g_floatsPerPose + componentOffset, _mm256_castps256_ps128(r2));
+	_mm_storeu_ps(poses + 3 * g_floatsPerPose + componentOffset, _mm256_castps256_ps128(r3));
+	_mm_storeu_ps(poses + 4 * g_floatsPerPose + componentOffset, _mm256_extractf128_ps(r0, 1));
+	_mm_storeu_ps(poses + 5 * g_floatsPerPose + componentOffset, _mm256_extractf128_ps(r1, 1));
+	_mm_storeu_ps(poses + 6 * g_floatsPerPose + componentOffset, _mm256_extractf128_ps(r2, 1));
+	_mm_storeu_ps(poses + 7 * g_floatsPerPose + componentOffset, _mm256_extractf128_ps(r3, 1));
+}
+
+AVX2_TARGET static inline __m256 Lerp8(__m256 a, __m256 b, __m256 t)
+{
+	return _mm256_fmadd_ps(_mm256_sub_ps(b, a), t, a);
+}
+
+AVX2_TARGET static inline void LerpComponent8(const float *src, const float *dst, float *out, int componentOffset, __m256 t)
+{
+	__m256 ax, ay, az, aw, bx, by, bz, bw;
+	LoadSoA8(src, componentOffset, ax, ay, az, aw);
+	LoadSoA8(dst, componentOffset, bx, by, bz, bw);
+	StoreSoA8(out, componentOffset, Lerp8(ax, bx, t), Lerp8(ay, by, t), Lerp8(az, bz, t), Lerp8(aw, bw, t));
+}
+
+AVX2_TARGET static void BlendPosesAVX2(const float *src, const float *dst, float *out, const float *weights, float weight, int numPoses)
+{
+	const __m256 signBit = _mm256_set1_ps(-0.f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 threeHalves = _mm256_set1_ps(1.5f);
+	const __m256 uniformWeight = _mm256_set1_ps(weight);
+	const __m256 minLengthSquared = _mm256_set1_ps(g_minRotationLengthSquared);
+
+	int i = 0;
+	for (; i + 8 <= numPoses; i += 8) {
+		int offset = i * g_floatsPerPose;
+		const float *a = src + offset;
+		const float *b = dst + offset;
+		float *o = out + offset;
+
+		// Lane layout matches LoadSoA8: weights i..i+3 in the low lane, i+4..i+7 in the high lane
+		__m256 t = weights ? _mm256_loadu_ps(weights + i) : uniformWeight;
+
+		__m256 ax, ay, az, aw, bx, by, bz, bw;
+		LoadSoA8(a, g_rotationOffset, ax, ay, az, aw);
+		LoadSoA8(b, g_rotationOffset, bx, by, bz, bw);
+
+		__m256 dot = _mm256_fmadd_ps(aw, bw, _mm256_fmadd_ps(az, bz, _mm256_fmadd_ps(ay, by, _mm256_mul_ps(ax, bx))));
+		__m256 flip = _mm256_and_ps(dot, signBit);
+		bx = _mm256_xor_ps(bx, flip);
+		by = _mm256_xor_ps(by, flip);
+		bz = _mm256_xor_ps(bz, flip);
+		bw = _mm256_xor_ps(bw, flip);
+
+		__m256 qx = Lerp8(ax, bx, t);
+		__m256 qy = Lerp8(ay, by, t);
+		__m256 qz = Lerp8(az, bz, t);
+		__m256 qw = Lerp8(aw, bw, t);
+
+		__m256 lengthSquared = _mm256_fmadd_ps(qw, qw, _mm256_fmadd_ps(qz, qz, _mm256_fmadd_ps(qy, qy, _mm256_mul_ps(qx, qx))));
+		__m256 r = _mm256_rsqrt_ps(lengthSquared);
+		r = _mm256_mul_ps(r, _mm256_sub_ps(threeHalves, _mm256_mul_ps(_mm256_mul_ps(half, lengthSquared), _mm256_mul_ps(r, r))));
+		r = _mm256_and_ps(r, _mm256_cmp_ps(lengthSquared, minLengthSquared, _CMP_GT_OQ));
+
+		StoreSoA8(o, g_rotationOffset, _mm256_mul_ps(qx, r), _mm256_mul_ps(qy, r), _mm256_mul_ps(qz, r), _mm256_mul_ps(qw, r));
+
+		LerpComponent8(a, b, o, g_translationOffset, t);
+		LerpComponent8(a, b, o, g_scaleOffset, t);
+	}
+
+	// Avoid the avx -> sse transition penalty before handing the rest off to the 4-wide kernel
+	_mm256_zeroupper();
+
+	int offset = i * g_floatsPerPose;
+	BlendPosesSSE(src + offset, dst + offset, out + offset, weights ? weights + i : nullptr, weight, numPoses - i);
+}
+
+
+static void CpuId(int leaf, int subleaf, int regs[4])
+{
+#ifdef _MSC_VER
+	__cpuidex(regs, leaf, subleaf);
+#else
+	unsigned int a, b, c, d;
+	__cpuid_count(leaf, subleaf, a, b, c, d);
+	regs[0] = a; regs[1] = b; regs[2] = c; regs[3] = d;
+#endif
+}
+
+static unsigned long long GetXCR0()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+static PoseBlendKernel SelectPoseBlendKernel()
+{
+	int regs[4];
+	CpuId(0, 0, regs);
+	int maxLeaf = regs[0];
+	if (maxLeaf < 1) return PoseBlendKernel::Portable;
+
+	CpuId(1, 0, regs);
+	bool hasSSE2 = regs[3] & (1 << 26);
+	bool hasFMA = regs[2] & (1 << 12);
+	bool hasOSXSave = regs[2] & (1 << 27);
+	bool hasAVX = regs[2] & (1 << 28);
+	if (!hasSSE2) return PoseBlendKernel::Portable;
+
+	// The os also needs to save the ymm registers on context switches
+	if (maxLeaf >= 7 && hasFMA && hasOSXSave && hasAVX && (GetXCR0() & 0x6) == 0x6) {
+		CpuId(7, 0, regs);
+		bool hasAVX2 = regs[1] & (1 << 5);
+		if (hasAVX2) return PoseBlendKernel::AVX2;
+	}
+
+	return PoseBlendKernel::SSE;
+}
+
+static const PoseBlendKernel g_poseBlendKernel = SelectPoseBlendKernel();
+
+PoseBlendKernel GetPoseBlendKernel()
+{
+	return g_poseBlendKernel;
+}
+
+const char * GetPoseBlendKernelName(PoseBlendKernel kernel)
+{
+	switch (kernel) {
+	case PoseBlendKernel::AVX2: return "AVX2";
+	case PoseBlendKernel::SSE: return "SSE";
+	default: return "Portable";
+	}
+}
+
+void BlendPoses(PoseBlendKernel kernel, const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, const float *weights, float weight, int numPoses)
+{
+	if (numPoses <= 0) return;
+
+	const float *src = (const float *)srcPoses;
+	const float *dst = (const float *)dstPoses;
+	float *out = (float *)outPoses;
+
+	if (kernel == PoseBlendKernel::AVX2) {
+		BlendPosesAVX2(src, dst, out, weights, weight, numPoses);
+	}
+	else if (kernel == PoseBlendKernel::SSE) {
+		BlendPosesSSE(src, dst, out, weights, weight, numPoses);
+	}
+	else {
+		BlendPosesPortable(src, dst, out, weights, weight, numPoses);
+	}
+}
+
+void BlendPoses(const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, const float *weights, int numPoses)
+{
+	BlendPoses(g_poseBlendKernel, srcPoses, dstPoses, outPoses, weights, 0.f, numPoses);
+}
+
+void BlendPoses(const hkQsTransform *srcPoses, const hkQsTransform *dstPoses, hkQsTransform *outPoses, float weight, int numPoses)
+{
+	BlendPoses(g_poseBlendKernel, srcPoses, dstPoses, outPoses, nullptr, weight, numPoses);
+}
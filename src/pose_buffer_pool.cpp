@@ -0,0 +1,98 @@
+#include <malloc.h>
+#include <type_traits>
+
+#include "pose_buffer_pool.h"
+#include "main.h"
+
+
+PoseBufferPool g_poseBufferPool;
+
+static inline size_t AlignSize(size_t size)
+{
+	return (size + 15) & ~size_t(15);
+}
+
+size_t PoseBufferPool::GetSlabSize(int numPoses, int numBones)
+{
+	return 6 * AlignSize(numPoses * sizeof(hkQsTransform)) + // anim, ragdoll, previous anim, previous ragdoll, initial and current pose
+		AlignSize(numPoses * sizeof(Blender::InertializationOffset)) +
+		AlignSize(numBones * sizeof(float)); // stress
+}
+
+bool PoseBufferPool::Acquire(ActiveRagdoll &ragdoll, int numPoses, int numBones)
+{
+	Release(ragdoll);
+
+	numPoses = std::max(numPoses, 0);
+	numBones = std::max(numBones, 0);
+
+	void *slab = nullptr;
+	std::vector<void *> &freeList = freeSlabs[GetKey(numPoses, numBones)];
+	if (!freeList.empty()) {
+		slab = freeList.back();
+		freeList.pop_back();
+	}
+	else {
+		slab = _aligned_malloc(GetSlabSize(numPoses, numBones), 16);
+		if (!slab) {
+			_ERROR("Failed to allocate pose buffers for %d poses and %d bones", numPoses, numBones);
+			return false;
+		}
+	}
+
+	UInt8 *memory = (UInt8 *)slab;
+	auto Carve = [&memory](auto &buffer, int count) {
+		using T = std::remove_pointer_t<decltype(buffer.data())>;
+		buffer.Reset((T *)memory, count);
+		memory += AlignSize(count * sizeof(T));
+	};
+
+	Carve(ragdoll.animPose, numPoses);
+	Carve(ragdoll.ragdollPose, numPoses);
+	Carve(ragdoll.previousAnimPose, numPoses);
+	Carve(ragdoll.previousRagdollPose, numPoses);
+	Carve(ragdoll.blender.initialPose, numPoses);
+	Carve(ragdoll.blender.currentPose, numPoses);
+	Carve(ragdoll.blender.offsets, numPoses);
+	Carve(ragdoll.stress, numBones);
+
+	ragdoll.poseSlab = slab;
+	ragdoll.poseSlabNumPoses = numPoses;
+	ragdoll.poseSlabNumBones = numBones;
+	return true;
+}
+
+void PoseBufferPool::Release(ActiveRagdoll &ragdoll)
+{
+	if (!ragdoll.poseSlab) return;
+
+	freeSlabs[GetKey(ragdoll.poseSlabNumPoses, ragdoll.poseSlabNumBones)].push_back(ragdoll.poseSlab);
+
+	ragdoll.animPose.Reset(nullptr, 0);
+	ragdoll.ragdollPose.Reset(nullptr, 0);
+	ragdoll.previousAnimPose.Reset(nullptr, 0);
+	ragdoll.previousRagdollPose.Reset(nullptr, 0);
+	ragdoll.blender.initialPose.Reset(nullptr, 0);
+	ragdoll.blender.currentPose.Reset(nullptr, 0);
+	ragdoll.blender.offsets.Reset(nullptr, 0);
+	ragdoll.stress.Reset(nullptr, 0);
+
+	ragdoll.poseSlab = nullptr;
+	ragdoll.poseSlabNumPoses = 0;
+	ragdoll.poseSlabNumBones = 0;
+}
+
+void PoseBufferPool::Trim()
+{
+	for (auto &[key, freeList] : freeSlabs) {
+		for (void *slab : freeList) {
+			_aligned_free(slab);
+		}
+	}
+	freeSlabs.clear();
+}
+
+PoseBufferPool::~PoseBufferPool()
+{
+	Trim();
+}
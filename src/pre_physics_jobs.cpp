@@ -0,0 +1,63 @@
+#include "pre_physics_jobs.h"
+#include "utils.h"
+#include "math_utils.h"
+#include "RE/havok.h"
+#include "RE/offsets.h"
+
+
+PrePhysicsJobs g_prePhysicsJobs;
+
+void PrePhysicsJobs::QueuePointImpulse(hkpRigidBody *rigidBody, const NiPoint3 &point, const NiPoint3 &impulse, UInt32 refrHandle)
+{
+	BodyImpulse &body = GetBodyImpulse(rigidBody, refrHandle);
+	body.pointImpulse += impulse;
+	body.pointMoment += CrossProduct(point, impulse);
+	body.hasPointImpulse = true;
+}
+
+// Need to be safe since the impulses could be applied next frame where the rigidbody might not exist anymore
+bool PrePhysicsJobs::IsBodyValid(hkpRigidBody *rigidBody, UInt32 refrHandle)
+{
+	if (indexedRefrs.insert(refrHandle)) {
+		if (NiPointer<TESObjectREFR> refr; LookupREFRByHandle(refrHandle, refr)) {
+			if (NiPointer<NiNode> root = refr->GetNiNode()) {
+				ForEachRigidBody(root, [this, refrHandle](hkpRigidBody *body) {
+					bodyRefrs[body] = refrHandle;
+				});
+			}
+		}
+	}
+
+	UInt32 *owner = bodyRefrs.find(rigidBody);
+	return owner && *owner == refrHandle && IsMoveableEntity(rigidBody);
+}
+
+void PrePhysicsJobs::Run()
+{
+	if (empty()) return;
+
+	for (const BodyImpulse &body : bodyImpulses) {
+		hkpRigidBody *rigidBody = body.rigidBody;
+		if (!IsBodyValid(rigidBody, body.refrHandle)) continue;
+
+		hkpEntity_activate(rigidBody);
+		rigidBody->m_motion.applyLinearImpulse(NiPointToHkVector(body.linearImpulse + body.pointImpulse));
+		if (body.hasPointImpulse) {
+			NiPoint3 centerOfMass = HkVectorToNiPoint(rigidBody->getCenterOfMassInWorld());
+			NiPoint3 angularImpulse = body.pointMoment - CrossProduct(centerOfMass, body.pointImpulse);
+			rigidBody->m_motion.applyAngularImpulse(NiPointToHkVector(angularImpulse));
+		}
+		//_MESSAGE("Applied impulse %.2f", VectorLength(body.linearImpulse + body.pointImpulse));
+	}
+
+	Clear();
+}
+
+void PrePhysicsJobs::Clear()
+{
+	// Keeps the capacity for the next frame
+	bodyImpulses.clear();
+	bodyIndices.clear();
+	indexedRefrs.clear();
+	bodyRefrs.clear();
+}
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <mutex>
+
+#include "race_cache.h"
+#include "config.h"
+
+
+RaceCache g_raceCache;
+
+extern BGSKeyword *g_keyword_actorTypeNPC;
+
+UInt32 RaceCache::ComputeFlags(TESRace *race)
+{
+	UInt32 raceFlags = RaceFlags::Valid;
+
+	bool isNPC = g_keyword_actorTypeNPC && race->keyword.HasKeyword(g_keyword_actorTypeNPC);
+	if (isNPC) {
+		raceFlags |= RaceFlags::NPC;
+	}
+
+	if (const char *name = race->editorId) {
+		std::string_view editorId(name);
+		if (Config::options.excludeRaces.count(editorId)) {
+			raceFlags |= RaceFlags::Excluded;
+		}
+		if (Config::options.aggressionExcludeRaces.count(editorId)) {
+			raceFlags |= RaceFlags::AggressionExcluded;
+		}
+		if (Config::options.additionalSelfCollisionRaces.count(editorId)) {
+			raceFlags |= RaceFlags::SelfCollidable;
+		}
+	}
+
+	if (isNPC && Config::options.doBipedSelfCollisionForNPCs) {
+		raceFlags |= RaceFlags::SelfCollidable;
+	}
+
+	raceFlags |= std::min<UInt32>(race->data.unk40, 0xFF) << RaceFlags::SizeShift;
+
+	return raceFlags;
+}
+
+UInt32 RaceCache::GetFlags(TESRace *race)
+{
+	{
+		std::shared_lock readLock(lock);
+		if (auto it = flags.find(race); it != flags.end()) {
+			return it->second;
+		}
+	}
+
+	UInt32 raceFlags = ComputeFlags(race);
+	{
+		std::unique_lock writeLock(lock);
+		flags[race] = raceFlags;
+	}
+	return raceFlags;
+}
+
+void RaceCache::Validate()
+{
+	if (optionsVersion == Config::optionsVersion) return;
+
+	Clear();
+	optionsVersion = Config::optionsVersion;
+}
+
+void RaceCache::Clear()
+{
+	std::unique_lock writeLock(lock);
+	flags.clear();
+}
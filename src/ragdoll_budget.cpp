@@ -0,0 +1,141 @@
+#include <algorithm>
+#include <climits>
+
+#include "ragdoll_budget.h"
+#include "config.h"
+
+
+RagdollBudget g_ragdollBudget;
+
+void RagdollBudget::AddCandidate(Actor *actor, float distance, bool isInteracting, bool isActive)
+{
+	candidates.push_back({ actor, distance, isInteracting, isActive, 0, 0.f });
+}
+
+void RagdollBudget::KeepActive(Actor *actor)
+{
+	auto it = records.find(actor);
+	if (it != records.end()) {
+		it->second.isKeptActive = true;
+	}
+}
+
+bool RagdollBudget::IsLimited()
+{
+	return Config::options.maxActiveRagdolls > 0 || Config::options.activeRagdollCostBudgetMicroseconds > 0.0;
+}
+
+bool RagdollBudget::IsAllowed(Actor *actor) const
+{
+	// Records are still kept up to date without limits, so that enabling one through a config reload doesn't start from scratch
+	if (!IsLimited()) return true;
+
+	auto it = records.find(actor);
+	return it != records.end() && it->second.isAllowed;
+}
+
+int RagdollBudget::GetMaxAllowed(int numActive)
+{
+	int maxAllowed = Config::options.maxActiveRagdolls > 0 ? Config::options.maxActiveRagdolls : INT_MAX;
+
+	double budget = Config::options.activeRagdollCostBudgetMicroseconds * 1e-6;
+	if (budget <= 0.0) return maxAllowed;
+
+	if (numActive > 0 && frameCost > 0.0) {
+		// Smooth the estimate out so that a single slow frame doesn't kick out a bunch of ragdolls
+		double costPerRagdoll = frameCost / numActive;
+		avgCostPerRagdoll = avgCostPerRagdoll > 0.0 ? avgCostPerRagdoll + (costPerRagdoll - avgCostPerRagdoll) * 0.1 : costPerRagdoll;
+	}
+
+	if (avgCostPerRagdoll > 0.0) {
+		// Always leave room for one ragdoll, otherwise the cost estimate can never recover
+		int maxAllowedByCost = std::max(1, (int)(budget / avgCostPerRagdoll));
+		maxAllowed = std::min(maxAllowed, maxAllowedByCost);
+	}
+
+	return maxAllowed;
+}
+
+void RagdollBudget::Resolve(double now)
+{
+	int numActive = 0;
+	for (const Candidate &candidate : candidates) {
+		if (candidate.isActive) ++numActive;
+	}
+
+	int maxAllowed = GetMaxAllowed(numActive);
+
+	for (Candidate &candidate : candidates) {
+		Record &record = records[candidate.actor];
+		record.isCandidate = true;
+
+		if (candidate.isInteracting) {
+			record.lastInteractionTime = now;
+		}
+
+		bool interactedRecently = record.lastInteractionTime >= 0.0 && now - record.lastInteractionTime < Config::options.budgetInteractionMemoryTime;
+		bool hasChanged = record.allowedChangedTime >= 0.0;
+		double timeSinceChange = now - record.allowedChangedTime;
+
+		// Tiers:
+		// 0 - being interacted with now or recently
+		// 1 - was promoted too recently to be demoted
+		// 2 - everyone else
+		// 3 - was demoted too recently to be promoted, never gets a slot
+		if (candidate.isInteracting || interactedRecently) {
+			candidate.tier = 0;
+		}
+		else if (record.isAllowed && hasChanged && timeSinceChange < Config::options.budgetDemoteCooldown) {
+			candidate.tier = 1;
+		}
+		else if (!record.isAllowed && hasChanged && timeSinceChange < Config::options.budgetPromoteCooldown) {
+			candidate.tier = 3;
+		}
+		else {
+			candidate.tier = 2;
+		}
+
+		// Favor actors that already have a slot, so two actors at about the same distance don't keep trading places
+		candidate.score = candidate.distance - (record.isAllowed ? Config::options.budgetHysteresisDistance : 0.f);
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+		if (a.tier != b.tier) return a.tier < b.tier;
+		return a.score < b.score;
+	});
+
+	int numAllowed = 0;
+	for (const Candidate &candidate : candidates) {
+		bool isAllowed = candidate.tier < 3 && numAllowed < maxAllowed;
+		if (isAllowed) ++numAllowed;
+
+		Record &record = records[candidate.actor];
+		if (record.isAllowed != isAllowed) {
+			record.isAllowed = isAllowed;
+			record.allowedChangedTime = now;
+		}
+	}
+
+	// Forget actors that went out of range, or whose ragdoll was removed
+	for (auto it = records.begin(); it != records.end();) {
+		if (!it->second.isCandidate && !it->second.isKeptActive) {
+			it = records.erase(it);
+		}
+		else {
+			it->second.isCandidate = false;
+			it->second.isKeptActive = false;
+			++it;
+		}
+	}
+
+	candidates.clear();
+	frameCost = 0.0;
+}
+
+void RagdollBudget::Clear()
+{
+	records.clear();
+	candidates.clear();
+	frameCost = 0.0;
+	avgCostPerRagdoll = 0.0;
+}
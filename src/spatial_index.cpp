@@ -0,0 +1,47 @@
+#include "spatial_index.h"
+#include "math_utils.h"
+
+
+SpatialIndex g_spatialIndex;
+
+void SpatialIndex::Clear()
+{
+	entries.clear();
+	refrToEntry.clear();
+}
+
+void SpatialIndex::Add(Actor *actor, UInt32 handle)
+{
+	entries.push_back({ actor->pos, actor, handle, 0.f });
+}
+
+void SpatialIndex::Build(const NiPoint3 &playerPosition)
+{
+	playerPos = playerPosition;
+
+	refrToEntry.clear();
+	for (UInt32 i = 0; i < (UInt32)entries.size(); i++) {
+		Entry &entry = entries[i];
+		entry.distanceToPlayer = VectorLength(entry.pos - playerPos);
+		refrToEntry[entry.actor] = i;
+	}
+}
+
+const SpatialIndex::Entry * SpatialIndex::Find(TESObjectREFR *refr) const
+{
+	auto it = refrToEntry.find(refr);
+	if (it == refrToEntry.end()) return nullptr;
+	return &entries[it->second];
+}
+
+NiPoint3 SpatialIndex::GetPosition(TESObjectREFR *refr) const
+{
+	if (refr == *g_thePlayer) return playerPos;
+	if (const Entry *entry = Find(refr)) return entry->pos;
+	return refr->pos;
+}
+
+bool SpatialIndex::AreWithinDistance(TESObjectREFR *refrA, TESObjectREFR *refrB, float distance) const
+{
+	return VectorLengthSquared(GetPosition(refrA) - GetPosition(refrB)) < distance * distance;
+}
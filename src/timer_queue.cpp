@@ -0,0 +1,107 @@
+#include <algorithm>
+
+#include "timer_queue.h"
+
+
+TimerQueue g_timerQueue;
+
+TimerToken TimerQueue::Schedule(InlineJob job, double runTime, TimerClock clock)
+{
+	UInt32 slotIndex;
+	if (!freeSlots.empty()) {
+		slotIndex = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		slotIndex = (UInt32)slots.size();
+		slots.emplace_back();
+	}
+
+	Slot &slot = slots[slotIndex];
+	slot.job = std::move(job);
+	slot.isPending = true;
+	++numPending;
+
+	std::vector<Node> &heap = heaps[(int)clock];
+	heap.push_back({ runTime, nextSequence++, slotIndex, slot.generation });
+	std::push_heap(heap.begin(), heap.end(), HeapOrder{});
+
+	return { slotIndex, slot.generation };
+}
+
+bool TimerQueue::IsPending(TimerToken token) const
+{
+	if (token.slot >= slots.size()) return false;
+	const Slot &slot = slots[token.slot];
+	return slot.isPending && slot.generation == token.generation;
+}
+
+bool TimerQueue::Cancel(TimerToken token)
+{
+	if (!IsPending(token)) return false;
+
+	// The heap node stays behind and is skipped since its generation no longer matches
+	Release(token.slot);
+	return true;
+}
+
+void TimerQueue::Release(UInt32 slotIndex)
+{
+	Slot &slot = slots[slotIndex];
+	slot.job.Reset();
+	slot.isPending = false;
+	if (++slot.generation == 0) slot.generation = 1;
+	freeSlots.push_back(slotIndex);
+	--numPending;
+}
+
+void TimerQueue::PopDue(std::vector<Node> &heap, double now)
+{
+	while (!heap.empty() && heap.front().runTime <= now) {
+		std::pop_heap(heap.begin(), heap.end(), HeapOrder{});
+		Node node = heap.back();
+		heap.pop_back();
+
+		const Slot &slot = slots[node.slot];
+		if (!slot.isPending || slot.generation != node.generation) continue; // cancelled
+
+		due.push_back(node);
+	}
+}
+
+void TimerQueue::Run(double realTime, double gameTime)
+{
+	if (numPending == 0) {
+		// Only cancelled nodes could be left
+		heaps[0].clear();
+		heaps[1].clear();
+		return;
+	}
+
+	// Take the due jobs out of the heaps first, so that jobs scheduled while running can't be picked up by this same Run()
+	due.clear();
+	PopDue(heaps[(int)TimerClock::Real], realTime);
+	PopDue(heaps[(int)TimerClock::Game], gameTime);
+
+	for (size_t i = 0; i < due.size(); i++) { // indexed, in case a job clears the queue
+		Node node = due[i];
+		Slot &slot = slots[node.slot];
+		if (!slot.isPending || slot.generation != node.generation) continue; // cancelled by an earlier job in this run
+
+		InlineJob job = std::move(slot.job);
+		Release(node.slot); // before running, so the job can schedule into its own slot
+		job();
+	}
+}
+
+void TimerQueue::Clear()
+{
+	for (UInt32 i = 0; i < slots.size(); i++) {
+		if (slots[i].isPending) {
+			Release(i);
+		}
+	}
+	heaps[0].clear();
+	heaps[1].clear();
+	due.clear();
+}
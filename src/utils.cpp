@@ -19,6 +19,7 @@
 
 ITimer g_timer;
 double g_currentFrameTime;
+double g_currentScaledFrameTime = 0.0;
 double GetTime()
 {
 	return g_timer.GetElapsedTime();
@@ -572,11 +573,11 @@ NiPointer<bhkRigidBody> GetFirstRigidBody(NiAVObject *root)
 	return nullptr;
 }
 
-bool FindRigidBody(NiAVObject *root, hkpRigidBody *query)
+void ForEachRigidBody(NiAVObject *root, std::function<void(hkpRigidBody *)> f)
 {
 	NiPointer<bhkRigidBody> rigidBody = GetRigidBody(root);
-	if (rigidBody && rigidBody->hkBody == query) {
-		return true;
+	if (rigidBody && rigidBody->hkBody) {
+		f(rigidBody->hkBody);
 	}
 
 	NiNode *node = root->GetAsNiNode();
@@ -584,14 +585,10 @@ bool FindRigidBody(NiAVObject *root, hkpRigidBody *query)
 		for (int i = 0; i < node->m_children.m_emptyRunStart; i++) {
 			auto child = node->m_children.m_data[i];
 			if (child) {
-				if (FindRigidBody(child, query)) {
-					return true;
-				}
+				ForEachRigidBody(child, f);
 			}
 		}
 	}
-
-	return false;
 }
 
 void ForEachRagdollDriver(Actor *actor, std::function<void(hkbRagdollDriver *)> f)
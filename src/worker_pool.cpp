@@ -0,0 +1,90 @@
+#include "worker_pool.h"
+
+
+WorkerPool::~WorkerPool()
+{
+	Stop();
+}
+
+void WorkerPool::Start(int numWorkers)
+{
+	Stop();
+
+	stopping = false;
+	for (int i = 0; i < numWorkers; i++) {
+		// Workers started after earlier ParallelFor() calls (e.g. a restart on a config change) must not take the last one for a new one
+		threads.emplace_back(&WorkerPool::WorkerLoop, this, generation);
+	}
+}
+
+void WorkerPool::Stop()
+{
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	threads.clear();
+}
+
+void WorkerPool::RunTasks()
+{
+	int i;
+	while ((i = nextIndex.fetch_add(1, std::memory_order_relaxed)) < taskCount) {
+		(*task)(i);
+	}
+}
+
+void WorkerPool::WorkerLoop(UInt64 lastGeneration)
+{
+	while (true) {
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			workAvailable.wait(guard, [&] { return stopping || generation != lastGeneration; });
+			if (stopping) return;
+			lastGeneration = generation;
+		}
+
+		RunTasks();
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			if (++numFinishedWorkers == (int)threads.size()) {
+				workDone.notify_one();
+			}
+		}
+	}
+}
+
+void WorkerPool::ParallelFor(int count, const std::function<void(int)> &func)
+{
+	if (count <= 0) return;
+
+	if (threads.empty() || count == 1) {
+		for (int i = 0; i < count; i++) {
+			func(i);
+		}
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		task = &func;
+		taskCount = count;
+		nextIndex = 0;
+		numFinishedWorkers = 0;
+		++generation;
+	}
+	workAvailable.notify_all();
+
+	RunTasks();
+
+	// Every worker checks in once per generation, even if there was nothing left for it to do, so none of them can still be looking at this task afterwards
+	std::unique_lock<std::mutex> guard(lock);
+	workDone.wait(guard, [&] { return numFinishedWorkers == (int)threads.size(); });
+	task = nullptr;
+}
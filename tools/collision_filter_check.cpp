@@ -0,0 +1,199 @@
+// Checks the precomputed collision filter table (src/collision_filter_table.cpp) against the collision filter callback it replaced.
+// Every pair of layers, same group or not, and every combination of GroupFlags on both groups is looked up in the table and compared with
+// a copy of the old callback, for all combinations of the options the policy reads and for a couple of higgs layers.
+//
+// Builds on its own, outside of the plugin, against stand-ins for the skse headers and the config (standin has to come first):
+//   g++ -std=c++17 -O2 -Istandin -I../include collision_filter_check.cpp ../src/collision_filter_table.cpp -o collision_filter_check
+//
+// Usage:
+//   collision_filter_check
+
+#include <cstdio>
+
+#include "collision_filter_table.h"
+#include "config.h"
+
+
+namespace Config {
+	Options options;
+	UInt32 optionsVersion = 0;
+}
+
+using CollisionFilterComparisonResult = HiggsPluginAPI::IHiggsInterface001::CollisionFilterComparisonResult;
+
+static UInt32 g_higgsCollisionLayer = 56;
+
+// Stands in for g_collisionGroupFlags, for the two groups the check uses
+static UInt8 g_groupFlags[2];
+
+struct GroupFlagsStandIn
+{
+	UInt8 Get(UInt16 group) const { return g_groupFlags[group]; }
+} g_collisionGroupFlagsStandIn;
+
+// CollisionFilterComparisonCallback from src/main.cpp as it was before the table, with g_collisionGroupFlags swapped for the stand-in
+static CollisionFilterComparisonResult CollisionFilterComparisonCallback(void * /*filter*/, UInt32 filterInfoA, UInt32 filterInfoB)
+{
+	GroupFlagsStandIn &g_collisionGroupFlags = g_collisionGroupFlagsStandIn;
+
+	UInt32 layerA = filterInfoA & 0x7f;
+	UInt32 layerB = filterInfoB & 0x7f;
+
+	if ((layerA == BGSCollisionLayer::kCollisionLayer_Biped || layerA == BGSCollisionLayer::kCollisionLayer_BipedNoCC) && (layerB == BGSCollisionLayer::kCollisionLayer_Biped || layerB == BGSCollisionLayer::kCollisionLayer_BipedNoCC)) {
+		// Biped vs. biped
+		UInt16 groupA = filterInfoA >> 16;
+		UInt16 groupB = filterInfoB >> 16;
+		if (groupA == groupB) {
+			// biped self-collision
+			if (g_collisionGroupFlags.Get(groupA) & GroupFlags::SelfCollidable) {
+				return CollisionFilterComparisonResult::Continue; // will collide with all non-adjacent bones
+			}
+			else {
+				return CollisionFilterComparisonResult::Ignore;
+			}
+		}
+		else {
+			// Biped vs. another biped
+			if (Config::options.doBipedNonSelfCollision) {
+				return CollisionFilterComparisonResult::Continue;
+			}
+			else {
+				return CollisionFilterComparisonResult::Ignore;
+			}
+		}
+	}
+
+	if (layerA != BGSCollisionLayer::kCollisionLayer_CharController && layerB != BGSCollisionLayer::kCollisionLayer_CharController) {
+		// Neither collidee is a character controller
+		return CollisionFilterComparisonResult::Continue;
+	}
+
+	if (layerA == BGSCollisionLayer::kCollisionLayer_CharController && layerB == BGSCollisionLayer::kCollisionLayer_CharController) {
+		// Both collidees are character controllers. If one of them is the player, ignore the collision.
+		UInt8 flagsA = g_collisionGroupFlags.Get(filterInfoA >> 16);
+		UInt8 flagsB = g_collisionGroupFlags.Get(filterInfoB >> 16);
+		if ((flagsA | flagsB) & GroupFlags::Player) {
+			UInt8 otherFlags = (flagsA & GroupFlags::Player) ? flagsB : flagsA;
+			if (otherFlags & GroupFlags::Hittable) {
+				// Still collide the player with hittable character controllers
+				return CollisionFilterComparisonResult::Continue;
+			}
+			return CollisionFilterComparisonResult::Ignore;
+		}
+		return CollisionFilterComparisonResult::Continue;
+	}
+
+	// One of the collidees is a character controller
+
+	UInt32 charControllerFilter = layerA == BGSCollisionLayer::kCollisionLayer_CharController ? filterInfoA : filterInfoB;
+	UInt8 flags = g_collisionGroupFlags.Get(charControllerFilter >> 16);
+	if (!(flags & GroupFlags::Player)) {
+		// It's not the player
+
+		UInt32 otherFilter = charControllerFilter == filterInfoA ? filterInfoB : filterInfoA;
+		UInt8 otherFlags = g_collisionGroupFlags.Get(otherFilter >> 16);
+		if (otherFlags & GroupFlags::Player) {
+			// Whatever collided with the charcontroller belongs to the player
+			UInt32 otherLayer = otherFilter & 0x7f;
+			if (otherLayer == g_higgsCollisionLayer) {
+				// Higgs vs. non-player character controller
+				if (flags & GroupFlags::Hittable) {
+					return CollisionFilterComparisonResult::Collide;
+				}
+				else {
+					return CollisionFilterComparisonResult::Ignore;
+				}
+			}
+		}
+
+		return CollisionFilterComparisonResult::Continue;
+	}
+
+	// The character controller belongs to the player
+
+	UInt32 otherFilter = charControllerFilter == filterInfoA ? filterInfoB : filterInfoA;
+	UInt32 otherLayer = otherFilter & 0x7f;
+	UInt8 otherFlags = g_collisionGroupFlags.Get(otherFilter >> 16);
+
+	if (!(otherFlags & GroupFlags::Player)) {
+		if (otherLayer == BGSCollisionLayer::kCollisionLayer_Biped || otherLayer == BGSCollisionLayer::kCollisionLayer_BipedNoCC) {
+			// Collide with the biped unless we want to explicitly ignore them
+			if (!Config::options.enablePlayerBipedCollision || (otherFlags & GroupFlags::Held)) {
+				return CollisionFilterComparisonResult::Ignore;
+			}
+
+			if (!(otherFlags & GroupFlags::ActiveBiped)) {
+				// Disable collision with biped objects that are not actors
+				return CollisionFilterComparisonResult::Ignore;
+			}
+
+			return CollisionFilterComparisonResult::Collide;
+		}
+	}
+
+	return CollisionFilterComparisonResult::Continue;
+}
+
+static const char * GetResultName(CollisionFilterComparisonResult result)
+{
+	switch (result) {
+	case CollisionFilterComparisonResult::Continue: return "continue";
+	case CollisionFilterComparisonResult::Collide: return "collide";
+	case CollisionFilterComparisonResult::Ignore: return "ignore";
+	default: return "?";
+	}
+}
+
+int main()
+{
+	constexpr int numFlags = 1 << 5; // every combination of the GroupFlags the policy looks at
+	constexpr int maxReportedMismatches = 10;
+
+	CollisionFilterTable table;
+	long long numChecked = 0;
+	long long numMismatches = 0;
+
+	for (UInt32 higgsLayer : { 56, 57 }) {
+		g_higgsCollisionLayer = higgsLayer;
+
+		for (int options = 0; options < 4; options++) {
+			Config::options.doBipedNonSelfCollision = options & 1;
+			Config::options.enablePlayerBipedCollision = options & 2;
+			++Config::optionsVersion;
+			table.Validate(higgsLayer);
+
+			for (UInt32 layerA = 0; layerA < 128; layerA++) {
+				for (UInt32 layerB = 0; layerB < 128; layerB++) {
+					for (int isSameGroup = 0; isSameGroup < 2; isSameGroup++) {
+						UInt32 filterInfoA = layerA;
+						UInt32 filterInfoB = (isSameGroup ? 0 : 1 << 16) | layerB;
+
+						for (int flagsA = 0; flagsA < numFlags; flagsA++) {
+							for (int flagsB = 0; flagsB < numFlags; flagsB++) {
+								if (isSameGroup && flagsA != flagsB) continue; // a group only has one set of flags
+
+								g_groupFlags[0] = flagsA;
+								g_groupFlags[isSameGroup ? 0 : 1] = flagsB;
+
+								CollisionFilterComparisonResult expected = CollisionFilterComparisonCallback(nullptr, filterInfoA, filterInfoB);
+								CollisionFilterComparisonResult result = table.Get(filterInfoA, filterInfoB, flagsA, flagsB);
+								++numChecked;
+
+								if (result != expected) {
+									if (numMismatches < maxReportedMismatches) {
+										printf("Mismatch: layers %u and %u, %s group, flags %02x and %02x, options %d, higgs layer %u: table says %s, callback says %s\n",
+											layerA, layerB, isSameGroup ? "same" : "different", flagsA, flagsB, options, higgsLayer, GetResultName(result), GetResultName(expected));
+									}
+									++numMismatches;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	printf("%lld combinations checked, %lld mismatches\n", numChecked, numMismatches);
+	return numMismatches ? 1 : 0;
+}
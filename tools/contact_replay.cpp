@@ -0,0 +1,358 @@
+// Offline replay of a contact recording (see recordContactEvents in the config and include/contact_record.h).
+// Runs the recorded contacts back through the hit classification and the per-hand hit cooldowns, with the recorded options or overridden ones,
+// and reports what would have been a hit, what changed compared to the recording, and how long classification takes.
+// The hand speed and direction of each contact are rebuilt from the recorded controller samples, so changes to the velocity averaging are replayed too.
+//
+// Builds on its own, outside of the plugin:
+//   g++ -std=c++17 -O2 -I../include contact_replay.cpp -o contact_replay
+//
+// Usage:
+//   contact_replay <recording> [--set name=value]... [--iterations n]
+// where name is one of the hit options in the config, e.g. --set hitSwingSpeedThreshold=4.5,
+// or controllerVelocityWindowSize for the number of controller samples that are averaged
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Stand-ins for the types the plugin gets from skse
+typedef std::uint8_t UInt8;
+typedef std::uint16_t UInt16;
+typedef std::uint32_t UInt32;
+typedef std::uint64_t UInt64;
+
+#include "contact_record.h"
+#include "expiring_map.h"
+#include "controller_velocity.h"
+
+
+// Stand-in for NiPoint3, with what ControllerVelocityData needs
+struct Vec3
+{
+	float x = 0.f, y = 0.f, z = 0.f;
+
+	Vec3 operator+(const Vec3 &other) const { return { x + other.x, y + other.y, z + other.z }; }
+	Vec3 operator/(float scalar) const { return { x / scalar, y / scalar, z / scalar }; }
+};
+
+static float VectorLength(const Vec3 &vec) { return sqrtf(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z); }
+static float DotProduct(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+static Vec3 VectorNormalized(const Vec3 &vec)
+{
+	float length = VectorLength(vec);
+	return length ? vec / length : Vec3();
+}
+
+
+struct Overrides
+{
+	std::vector<std::pair<std::string, double>> values;
+	int controllerVelocityWindowSize = ControllerVelocityData<Vec3>::DefaultWindowSize;
+
+	bool Apply(ContactRecord::Config &config) const
+	{
+		for (auto &[name, value] : values) {
+			if (name == "hitStabDirectionThreshold") config.hit.stabDirectionThreshold = (float)value;
+			else if (name == "hitStabSpeedThreshold") config.hit.stabSpeedThreshold = (float)value;
+			else if (name == "hitPunchDirectionThreshold") config.hit.punchDirectionThreshold = (float)value;
+			else if (name == "hitPunchSpeedThreshold") config.hit.punchSpeedThreshold = (float)value;
+			else if (name == "hitSwingSpeedThreshold") config.hit.swingSpeedThreshold = (float)value;
+			else if (name == "hitRequiredHandSpeedRoomspace") config.hit.requiredHandSpeedRoomspace = (float)value;
+			else if (name == "disableHitIfSheathed") config.hit.disableHitIfSheathed = value != 0.0;
+			else if (name == "hitCooldownTimeStoppedColliding") config.hitCooldownTimeStoppedColliding = value;
+			else if (name == "hitCooldownTimeFallback") config.hitCooldownTimeFallback = value;
+			else {
+				fprintf(stderr, "Unknown option %s\n", name.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+struct ReplayContact
+{
+	ContactRecord::Contact contact;
+	ContactRecord::Config config; // in effect at the time of the contact
+	double time;
+};
+
+struct Stats
+{
+	int numSteps = 0;
+	int numControllerSamples = 0;
+	int numContacts = 0;
+	int numHandMotionRebuilt = 0;
+	int numHandMotionFromRecording = 0; // before there were enough controller samples to fill the window
+	int numHandMotionChanged = 0;
+	int numByType[4]{};
+	int numDisabled = 0;
+	int numHits = 0;
+	int numSuppressedByCooldown = 0;
+	int numChangedFromRecording = 0;
+	int numSkippedRecords = 0;
+};
+
+static const char * GetHitTypeName(int type)
+{
+	static const char *names[] = { "none", "stab", "punch", "swing" };
+	return type >= 0 && type < 4 ? names[type] : "?";
+}
+
+// Recomputes the hand speed and direction dependent parts of the classification input from the controller samples seen so far, the same way the game does.
+// Contacts from before the window has filled up keep their recorded input, since the samples from before the recording started are unknown.
+static void RebuildHandMotion(ContactRecord::Contact &contact, const ControllerVelocityData<Vec3> (&controllerVelocities)[2], const int (&numSamples)[2], int windowSize, Stats &stats)
+{
+	bool isLeft = contact.isLeft;
+	bool hasSamples = contact.isTwoHanding ? numSamples[0] >= windowSize && numSamples[1] >= windowSize : numSamples[isLeft] >= windowSize;
+	if (!hasSamples) {
+		++stats.numHandMotionFromRecording;
+		return;
+	}
+
+	Vec3 handDirection;
+	float handSpeedRoomspace;
+	GetHandMotion(controllerVelocities, isLeft, contact.isTwoHanding, handDirection, handSpeedRoomspace);
+
+	HitClassificationInput &input = contact.input;
+	HitClassificationInput recordedInput = input;
+	Vec3 referenceDirection{ contact.referenceDirection[0], contact.referenceDirection[1], contact.referenceDirection[2] };
+
+	input.handSpeedRoomspace = handSpeedRoomspace;
+	if (input.hasWeaponNode) {
+		if (input.weaponType == HitWeaponType::Stabbing) {
+			input.stabAmount = DotProduct(handDirection, referenceDirection);
+		}
+		else if (input.weaponType == HitWeaponType::Unarmed) {
+			input.punchAmount = DotProduct(handDirection, referenceDirection);
+		}
+	}
+
+	++stats.numHandMotionRebuilt;
+	constexpr float tolerance = 1e-4f;
+	if (fabsf(input.handSpeedRoomspace - recordedInput.handSpeedRoomspace) > tolerance ||
+		fabsf(input.stabAmount - recordedInput.stabAmount) > tolerance ||
+		fabsf(input.punchAmount - recordedInput.punchAmount) > tolerance) {
+		++stats.numHandMotionChanged;
+	}
+}
+
+static bool ReadRecording(const char *path, const Overrides &overrides, std::vector<ReplayContact> &contacts, Stats &stats)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		fprintf(stderr, "Failed to open %s\n", path);
+		return false;
+	}
+
+	ContactRecord::FileHeader fileHeader;
+	if (!file.read((char *)&fileHeader, sizeof(fileHeader)) || fileHeader.magic != ContactRecord::Magic) {
+		fprintf(stderr, "%s is not a contact recording\n", path);
+		return false;
+	}
+	if (fileHeader.version != ContactRecord::Version) {
+		fprintf(stderr, "%s is version %u, this tool reads version %u\n", path, fileHeader.version, ContactRecord::Version);
+		return false;
+	}
+
+	ContactRecord::Config config{};
+	bool hasConfig = false;
+	double stepTime = 0.0;
+
+	int windowSize = overrides.controllerVelocityWindowSize;
+	ControllerVelocityData<Vec3> controllerVelocities[2] = { windowSize, windowSize };
+	int numSamples[2]{};
+
+	ContactRecord::RecordHeader header;
+	std::vector<char> payload;
+	while (file.read((char *)&header, sizeof(header))) {
+		payload.resize(header.size);
+		if (!file.read(payload.data(), header.size)) {
+			fprintf(stderr, "Recording ends in the middle of a record, ignoring the rest\n");
+			break;
+		}
+
+		switch (header.type) {
+		case ContactRecord::Type::Step:
+			if (header.size == sizeof(ContactRecord::Step)) {
+				ContactRecord::Step step;
+				memcpy(&step, payload.data(), sizeof(step));
+				stepTime = step.frameTime;
+				++stats.numSteps;
+			}
+			break;
+		case ContactRecord::Type::Config:
+			if (header.size == sizeof(ContactRecord::Config)) {
+				memcpy(&config, payload.data(), sizeof(config));
+				if (!overrides.Apply(config)) return false;
+				hasConfig = true;
+			}
+			break;
+		case ContactRecord::Type::ControllerSample:
+			if (header.size == sizeof(ContactRecord::ControllerSample)) {
+				ContactRecord::ControllerSample sample;
+				memcpy(&sample, payload.data(), sizeof(sample));
+				int hand = sample.isLeft ? 1 : 0;
+				controllerVelocities[hand].Add({ sample.velocity[0], sample.velocity[1], sample.velocity[2] });
+				++numSamples[hand];
+				++stats.numControllerSamples;
+			}
+			break;
+		case ContactRecord::Type::Contact:
+			if (header.size == sizeof(ContactRecord::Contact) && hasConfig) {
+				ReplayContact replayContact;
+				memcpy(&replayContact.contact, payload.data(), sizeof(replayContact.contact));
+				RebuildHandMotion(replayContact.contact, controllerVelocities, numSamples, windowSize, stats);
+				replayContact.config = config;
+				replayContact.time = stepTime;
+				contacts.push_back(replayContact);
+			}
+			break;
+		default:
+			++stats.numSkippedRecords;
+			break;
+		}
+	}
+
+	return true;
+}
+
+// Mirrors the hit cooldown handling in ContactListener: a refr that was hit by a hand ignores that hand until it has stopped touching it for a bit,
+// or for a fallback time at most. The recording only has the contacts that reached classification, so "still touching" is approximated by "still has contacts".
+static void Replay(const std::vector<ReplayContact> &contacts, Stats &stats)
+{
+	struct Cooldown
+	{
+		double startTime;
+		double stoppedCollidingTime;
+	};
+	ExpiringMap<const void *, Cooldown> cooldowns[2];
+
+	auto getExpiryTime = [](const Cooldown &cooldown, const ContactRecord::Config &config) {
+		return std::min(cooldown.stoppedCollidingTime + config.hitCooldownTimeStoppedColliding, cooldown.startTime + config.hitCooldownTimeFallback);
+	};
+
+	for (const ReplayContact &replayContact : contacts) {
+		const ContactRecord::Contact &contact = replayContact.contact;
+		const void *hitRefr = (const void *)(uintptr_t)contact.hitRefr;
+		auto &handCooldowns = cooldowns[contact.isLeft ? 1 : 0];
+		handCooldowns.Expire(replayContact.time);
+
+		++stats.numContacts;
+
+		if (Cooldown *cooldown = handCooldowns.find(hitRefr)) {
+			cooldown->stoppedCollidingTime = replayContact.time;
+			handCooldowns.SetExpiryTime(hitRefr, getExpiryTime(*cooldown, replayContact.config));
+			++stats.numSuppressedByCooldown;
+			continue;
+		}
+
+		HitClassification result = ClassifyHit(contact.input, replayContact.config.hit);
+		++stats.numByType[(int)result.type];
+		if (result.isDisabled) ++stats.numDisabled;
+
+		if (result.type != contact.result.type || result.isDisabled != contact.result.isDisabled) {
+			++stats.numChangedFromRecording;
+		}
+
+		if (result.IsHit()) {
+			++stats.numHits;
+			Cooldown cooldown{ replayContact.time, replayContact.time };
+			handCooldowns.Set(hitRefr, cooldown, getExpiryTime(cooldown, replayContact.config));
+		}
+	}
+}
+
+static double TimeClassification(const std::vector<ReplayContact> &contacts, int iterations)
+{
+	if (contacts.empty() || iterations <= 0) return 0.0;
+
+	int numHits = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		for (const ReplayContact &replayContact : contacts) {
+			numHits += ClassifyHit(replayContact.contact.input, replayContact.config.hit).IsHit();
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	volatile int sink = numHits; (void)sink; // keep the loop from being optimized out
+	double seconds = std::chrono::duration<double>(end - start).count();
+	return seconds * 1e9 / ((double)contacts.size() * iterations);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <recording> [--set name=value]... [--iterations n]\n", argv[0]);
+		return 1;
+	}
+
+	const char *path = argv[1];
+	Overrides overrides;
+	int iterations = 100;
+
+	for (int i = 2; i < argc; i++) {
+		if (!strcmp(argv[i], "--set") && i + 1 < argc) {
+			std::string setting = argv[++i];
+			size_t equals = setting.find('=');
+			if (equals == std::string::npos) {
+				fprintf(stderr, "Expected name=value, got %s\n", setting.c_str());
+				return 1;
+			}
+			std::string name = setting.substr(0, equals);
+			double value = atof(setting.c_str() + equals + 1);
+			if (name == "controllerVelocityWindowSize") {
+				if (value < 1) {
+					fprintf(stderr, "controllerVelocityWindowSize must be at least 1\n");
+					return 1;
+				}
+				overrides.controllerVelocityWindowSize = (int)value;
+			}
+			else {
+				overrides.values.push_back({ name, value });
+			}
+		}
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+			iterations = atoi(argv[++i]);
+		}
+		else {
+			fprintf(stderr, "Unknown argument %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	Stats stats;
+	std::vector<ReplayContact> contacts;
+	if (!ReadRecording(path, overrides, contacts, stats)) return 1;
+
+	Replay(contacts, stats);
+	double nsPerContact = TimeClassification(contacts, iterations);
+
+	printf("steps: %d\n", stats.numSteps);
+	printf("controller samples: %d\n", stats.numControllerSamples);
+	printf("contacts: %d\n", stats.numContacts);
+	printf("hand motion rebuilt from controller samples: %d (%d changed from recording, %d kept as recorded)\n",
+		stats.numHandMotionRebuilt, stats.numHandMotionChanged, stats.numHandMotionFromRecording);
+	printf("suppressed by cooldown: %d\n", stats.numSuppressedByCooldown);
+	for (int type = 0; type < 4; type++) {
+		printf("classified %s: %d\n", GetHitTypeName(type), stats.numByType[type]);
+	}
+	printf("disabled (hand too slow or sheathed): %d\n", stats.numDisabled);
+	printf("hits: %d\n", stats.numHits);
+	printf("changed from recording: %d\n", stats.numChangedFromRecording);
+	if (stats.numSkippedRecords > 0) {
+		printf("skipped records of unknown type: %d\n", stats.numSkippedRecords);
+	}
+	printf("classification time: %.2f ns per contact (%d iterations)\n", nsPerContact, iterations);
+
+	return 0;
+}
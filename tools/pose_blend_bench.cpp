@@ -0,0 +1,198 @@
+// Checks the SSE and AVX2 pose blending kernels (src/pose_blend.cpp) against the portable one, and times all three.
+// Poses are random, with about half of the dst rotations in the opposite hemisphere to exercise the sign flip, and bone counts that aren't
+// multiples of 4 or 8 to exercise the tail handling. Both per-bone and uniform weights are checked, as well as out aliasing src and rotations
+// that blend to zero length.
+//
+// Builds on its own, outside of the plugin, against a stand-in hkQsTransform:
+//   g++ -std=c++17 -O2 -I../include -Istandin pose_blend_bench.cpp ../src/pose_blend.cpp -o pose_blend_bench
+//
+// Usage:
+//   pose_blend_bench [--bones n] [--ragdolls n] [--iterations n]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "pose_blend.h"
+
+
+static constexpr float g_tolerance = 1e-5f; // relative; rsqrt + one newton-raphson step, and fma vs. separate mul and add
+
+struct Poses
+{
+	std::vector<hkQsTransform> src;
+	std::vector<hkQsTransform> dst;
+	std::vector<float> weights;
+};
+
+static void RandomVector(std::mt19937 &rng, float *out, float scale)
+{
+	std::uniform_real_distribution<float> dist(-scale, scale);
+	for (int i = 0; i < 4; i++) out[i] = dist(rng);
+}
+
+static void RandomQuaternion(std::mt19937 &rng, float *out)
+{
+	float lengthSquared = 0.f;
+	do {
+		RandomVector(rng, out, 1.f);
+		lengthSquared = out[0] * out[0] + out[1] * out[1] + out[2] * out[2] + out[3] * out[3];
+	} while (lengthSquared < 0.01f);
+
+	float invLength = 1.f / sqrtf(lengthSquared);
+	for (int i = 0; i < 4; i++) out[i] *= invLength;
+}
+
+static Poses MakePoses(int numPoses, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> weightDist(0.f, 1.f);
+
+	Poses poses;
+	poses.src.resize(numPoses);
+	poses.dst.resize(numPoses);
+	poses.weights.resize(numPoses);
+	for (int i = 0; i < numPoses; i++) {
+		for (hkQsTransform *pose : { &poses.src[i], &poses.dst[i] }) {
+			RandomVector(rng, pose->m_translation.v, 100.f);
+			RandomQuaternion(rng, pose->m_rotation.m_vec.v);
+			RandomVector(rng, pose->m_scale.v, 2.f);
+		}
+		poses.weights[i] = weightDist(rng);
+	}
+	return poses;
+}
+
+static float GetMaxError(const std::vector<hkQsTransform> &expected, const std::vector<hkQsTransform> &actual)
+{
+	float maxError = 0.f;
+	const float *a = (const float *)expected.data();
+	const float *b = (const float *)actual.data();
+	for (size_t i = 0; i < expected.size() * 12; i++) {
+		float error = fabsf(a[i] - b[i]) / fmaxf(1.f, fabsf(a[i]));
+		if (!(error <= maxError)) maxError = error; // also catches nan
+	}
+	return maxError;
+}
+
+// Rotations that blend to (nearly) zero length, which have to come out as zero rather than nan: zero quaternions on both sides,
+// and quaternions too short to normalize. Only every other bone, so that the degenerate lanes sit next to normal ones.
+static void MakeDegenerateRotations(Poses &poses)
+{
+	for (size_t i = 0; i < poses.src.size(); i += 2) {
+		float scale = (i / 2) % 2 ? 1e-20f : 0.f;
+		for (int j = 0; j < 4; j++) {
+			poses.src[i].m_rotation.m_vec.v[j] *= scale;
+			poses.dst[i].m_rotation.m_vec.v[j] *= scale;
+		}
+	}
+}
+
+// Returns the number of failed checks
+static int Check(PoseBlendKernel kernel)
+{
+	int numFailed = 0;
+	const int boneCounts[] = { 1, 3, 4, 5, 7, 8, 9, 13, 16, 100, 101 };
+	for (int numPoses : boneCounts) {
+		for (int isDegenerate = 0; isDegenerate < 2; isDegenerate++) {
+			Poses poses = MakePoses(numPoses, 1234 + numPoses);
+			if (isDegenerate) MakeDegenerateRotations(poses);
+
+			for (int isUniform = 0; isUniform < 2; isUniform++) {
+				const float *weights = isUniform ? nullptr : poses.weights.data();
+				float weight = 0.37f;
+
+				std::vector<hkQsTransform> expected(numPoses);
+				BlendPoses(PoseBlendKernel::Portable, poses.src.data(), poses.dst.data(), expected.data(), weights, weight, numPoses);
+
+				std::vector<hkQsTransform> actual(numPoses);
+				BlendPoses(kernel, poses.src.data(), poses.dst.data(), actual.data(), weights, weight, numPoses);
+
+				// Same again with out aliasing src
+				std::vector<hkQsTransform> aliased = poses.src;
+				BlendPoses(kernel, aliased.data(), poses.dst.data(), aliased.data(), weights, weight, numPoses);
+
+				float error = GetMaxError(expected, actual);
+				float aliasedError = GetMaxError(expected, aliased);
+				if (!(error <= g_tolerance) || !(aliasedError <= g_tolerance)) {
+					printf("FAIL %s, %d bones%s, %s weights: max error %g, aliased %g\n",
+						GetPoseBlendKernelName(kernel), numPoses, isDegenerate ? " with degenerate rotations" : "", isUniform ? "uniform" : "per-bone", error, aliasedError);
+					++numFailed;
+				}
+			}
+		}
+	}
+	return numFailed;
+}
+
+static double Time(PoseBlendKernel kernel, const Poses &poses, int numBones, int numRagdolls, int iterations)
+{
+	std::vector<hkQsTransform> out(poses.src.size());
+
+	// Warm up the caches and let the cpu clock up before timing
+	for (int ragdoll = 0; ragdoll < numRagdolls; ragdoll++) {
+		int offset = ragdoll * numBones;
+		BlendPoses(kernel, poses.src.data() + offset, poses.dst.data() + offset, out.data() + offset, poses.weights.data() + offset, 0.f, numBones);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (int iteration = 0; iteration < iterations; iteration++) {
+		for (int ragdoll = 0; ragdoll < numRagdolls; ragdoll++) {
+			int offset = ragdoll * numBones;
+			BlendPoses(kernel, poses.src.data() + offset, poses.dst.data() + offset, out.data() + offset, poses.weights.data() + offset, 0.f, numBones);
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	volatile float sink = out[0].m_rotation.m_vec.v[0]; (void)sink; // keep the blends from being optimized out
+	double seconds = std::chrono::duration<double>(end - start).count();
+	return seconds * 1e6 / iterations;
+}
+
+int main(int argc, char **argv)
+{
+	int numBones = 100;
+	int numRagdolls = 20;
+	int iterations = 1000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--bones") && i + 1 < argc) numBones = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--ragdolls") && i + 1 < argc) numRagdolls = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "Usage: %s [--bones n] [--ragdolls n] [--iterations n]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (numBones <= 0 || numRagdolls <= 0 || iterations <= 0) {
+		fprintf(stderr, "Counts must be positive\n");
+		return 1;
+	}
+
+	PoseBlendKernel best = GetPoseBlendKernel();
+	printf("cpu supports up to the %s kernel\n", GetPoseBlendKernelName(best));
+
+	std::vector<PoseBlendKernel> kernels{ PoseBlendKernel::Portable };
+	if (best == PoseBlendKernel::SSE || best == PoseBlendKernel::AVX2) kernels.push_back(PoseBlendKernel::SSE);
+	if (best == PoseBlendKernel::AVX2) kernels.push_back(PoseBlendKernel::AVX2);
+
+	int numFailed = 0;
+	for (PoseBlendKernel kernel : kernels) {
+		if (kernel != PoseBlendKernel::Portable) numFailed += Check(kernel);
+	}
+	printf("%s\n", numFailed ? "kernels do NOT match the portable kernel" : "kernels match the portable kernel");
+
+	Poses poses = MakePoses(numBones * numRagdolls, 42);
+	double portableTime = 0.0;
+	for (PoseBlendKernel kernel : kernels) {
+		double time = Time(kernel, poses, numBones, numRagdolls, iterations);
+		if (kernel == PoseBlendKernel::Portable) portableTime = time;
+		printf("%-8s %8.2f us per frame (%d bones x %d ragdolls), %.2fx\n", GetPoseBlendKernelName(kernel), time, numBones, numRagdolls, portableTime / time);
+	}
+
+	return numFailed ? 1 : 0;
+}
@@ -0,0 +1,360 @@
+// Compares the way hit impulses used to be queued for the physics step with PrePhysicsJobs (src/pre_physics_jobs.cpp), and checks that both end up
+// with the same body velocities.
+// The old way allocated a job per impulse, behind a virtual Run(), and each job looked up its refr and walked the refr's scene graph to check that the body
+// was still part of it. PrePhysicsJobs sums the impulses per body as they are queued and walks each refr's scene graph once per step.
+// Neither the game's scene graph nor havok is available here, so the real PrePhysicsJobs is built against stand-ins for them, and the old way is a copy
+// written against the same stand-ins.
+// Impulses are queued the way hits queue them: a point impulse on the hit body and linear impulses on the 3 adjacent ones, with a few hits on bodies that
+// are gone by the time the impulses are applied.
+//
+// Builds on its own, outside of the plugin, against stand-ins for the skse and havok headers and the prefix header (standin has to come first):
+//   g++ -std=c++17 -O2 -Istandin -include common/IPrefix.h -I../include pre_physics_jobs_bench.cpp ../src/pre_physics_jobs.cpp -o pre_physics_jobs_bench
+//
+// Usage:
+//   pre_physics_jobs_bench [--actors n] [--iterations n]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pre_physics_jobs.h"
+#include "utils.h"
+#include "math_utils.h"
+#include "RE/havok.h"
+#include "RE/offsets.h"
+
+
+static constexpr float g_tolerance = 1e-4f; // relative; the impulses are summed in a different order
+
+// Stand-in for the game's refrs and their 3d: a node, with the rigid body of its collision object if it has one
+struct Scene
+{
+	std::vector<std::unique_ptr<NiNode>> nodes;
+	std::vector<std::unique_ptr<hkpRigidBody>> bodies;
+	std::vector<TESObjectREFR> refrs;
+	std::vector<TESObjectREFR *> handles; // handle -> refr, null once the refr is gone
+	std::vector<std::vector<hkpRigidBody *>> refrBodies; // per handle, in skeleton order, for picking hit bodies
+
+	Scene() = default;
+	Scene(const Scene &) = delete; // handles point into refrs
+};
+
+// The scene that handles are looked up in. Both paths run on their own scene, so this is switched before running either.
+static const Scene *g_scene = nullptr;
+
+// What the stand-in headers declare and the plugin defines elsewhere
+
+bool LookupREFRByHandle(UInt32 &refHandle, NiPointer<TESObjectREFR> &refrOut)
+{
+	refrOut = refHandle < g_scene->handles.size() ? g_scene->handles[refHandle] : nullptr;
+	return refrOut != nullptr;
+}
+
+void ForEachRigidBody(NiAVObject *root, std::function<void(hkpRigidBody *)> f)
+{
+	if (root->m_rigidBody) {
+		f(root->m_rigidBody);
+	}
+
+	if (NiNode *node = root->GetAsNiNode()) {
+		for (NiAVObject *child : node->m_children) {
+			ForEachRigidBody(child, f);
+		}
+	}
+}
+
+NiPoint3 CrossProduct(const NiPoint3 &vec1, const NiPoint3 &vec2)
+{
+	return NiPoint3(vec1.y * vec2.z - vec1.z * vec2.y, vec1.z * vec2.x - vec1.x * vec2.z, vec1.x * vec2.y - vec1.y * vec2.x);
+}
+
+// Skyrim skeletons have about 100 nodes, of which a dozen or two have rigid bodies
+static void MakeScene(Scene &scene, int numActors, unsigned seed)
+{
+	constexpr int numNodesPerActor = 100;
+	constexpr int nodesPerBody = 5;
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> positionDist(-100.f, 100.f);
+	std::uniform_real_distribution<float> massDist(0.5f, 2.f);
+
+	scene.refrs.resize(numActors + 1);
+	scene.handles.resize(numActors + 1);
+	scene.refrBodies.resize(numActors + 1);
+	for (int actor = 0; actor <= numActors; actor++) {
+		NiNode *root = nullptr;
+		std::vector<NiNode *> actorNodes;
+		for (int i = 0; i < numNodesPerActor; i++) {
+			NiNode *node = scene.nodes.emplace_back(std::make_unique<NiNode>()).get();
+			if (i == 0) {
+				root = node;
+			}
+			else {
+				std::uniform_int_distribution<int> parentDist(std::max(0, i - 4), i - 1);
+				actorNodes[parentDist(rng)]->m_children.push_back(node);
+			}
+			actorNodes.push_back(node);
+
+			if (i % nodesPerBody == nodesPerBody - 1) {
+				hkpRigidBody *body = scene.bodies.emplace_back(std::make_unique<hkpRigidBody>()).get();
+				float invMass = 1.f / massDist(rng);
+				float invInertia = invMass * 0.1f;
+				body->m_motion.m_centerOfMass = { { positionDist(rng), positionDist(rng), positionDist(rng), 0.f } };
+				body->m_motion.m_inertiaAndMassInv = { { invInertia, invInertia, invInertia, invMass } };
+				node->m_rigidBody = body;
+				scene.refrBodies[actor].push_back(body);
+			}
+		}
+		scene.refrs[actor].m_root = root;
+		scene.handles[actor] = &scene.refrs[actor];
+	}
+
+	// The last actor is gone by the time the impulses are applied, so its hits have to be skipped
+	scene.handles[numActors] = nullptr;
+}
+
+struct Impulse
+{
+	bool isPoint;
+	int actor;
+	int bodyIndex;
+	NiPoint3 point;
+	NiPoint3 impulse;
+};
+
+static std::vector<Impulse> MakeImpulses(const Scene &scene, int numImpulses, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	int numActors = (int)scene.refrBodies.size() - 1;
+	std::uniform_int_distribution<int> actorDist(0, numActors - 1);
+	std::uniform_int_distribution<int> percentDist(0, 99);
+	std::uniform_real_distribution<float> dist(-10.f, 10.f);
+
+	std::vector<Impulse> impulses;
+	while ((int)impulses.size() < numImpulses) {
+		int actor = percentDist(rng) == 0 ? numActors : actorDist(rng);
+		int numBodies = (int)scene.refrBodies[actor].size();
+		int bodyIndex = std::uniform_int_distribution<int>(0, numBodies - 1)(rng);
+		NiPoint3 hitVelocity(dist(rng), dist(rng), dist(rng));
+
+		// The hit body and then the adjacent ones, with less and less of the impulse
+		impulses.push_back({ true, actor, bodyIndex, NiPoint3(dist(rng), dist(rng), dist(rng)), hitVelocity });
+		float decay = 1.f;
+		for (int i = 1; i <= 3 && (int)impulses.size() < numImpulses; i++) {
+			decay *= 0.5f;
+			impulses.push_back({ false, actor, (bodyIndex + i) % numBodies, NiPoint3(), hitVelocity * decay });
+		}
+	}
+	return impulses;
+}
+
+// The old way, as it was in src/main.cpp
+
+static bool FindRigidBody(NiAVObject *root, hkpRigidBody *query)
+{
+	if (root->m_rigidBody == query) {
+		return true;
+	}
+
+	if (NiNode *node = root->GetAsNiNode()) {
+		for (NiAVObject *child : node->m_children) {
+			if (FindRigidBody(child, query)) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+static void ApplyPointImpulse(hkpRigidBody *rigidBody, const NiPoint3 &impulse, const NiPoint3 &point)
+{
+	NiPoint3 centerOfMass = HkVectorToNiPoint(rigidBody->getCenterOfMassInWorld());
+	rigidBody->m_motion.applyLinearImpulse(NiPointToHkVector(impulse));
+	rigidBody->m_motion.applyAngularImpulse(NiPointToHkVector(CrossProduct(point - centerOfMass, impulse)));
+}
+
+struct GenericJob
+{
+	virtual ~GenericJob() = default;
+	virtual void Run() = 0;
+};
+
+struct PointImpulseJob : GenericJob
+{
+	hkpRigidBody *rigidBody{};
+	NiPoint3 point{};
+	NiPoint3 impulse{};
+	UInt32 refrHandle{};
+
+	PointImpulseJob(hkpRigidBody *rigidBody, const NiPoint3 &point, const NiPoint3 &impulse, UInt32 refrHandle) :
+		rigidBody(rigidBody), point(point), impulse(impulse), refrHandle(refrHandle) {}
+
+	virtual void Run() override
+	{
+		if (NiPointer<TESObjectREFR> refr; LookupREFRByHandle(refrHandle, refr)) {
+			NiPointer<NiNode> root = refr->GetNiNode();
+			if (root && FindRigidBody(root, rigidBody)) {
+				if (IsMoveableEntity(rigidBody)) {
+					hkpEntity_activate(rigidBody);
+					ApplyPointImpulse(rigidBody, impulse, point);
+				}
+			}
+		}
+	}
+};
+
+struct LinearImpulseJob : GenericJob
+{
+	hkpRigidBody *rigidBody{};
+	NiPoint3 impulse{};
+	UInt32 refrHandle{};
+
+	LinearImpulseJob(hkpRigidBody *rigidBody, const NiPoint3 &impulse, UInt32 refrHandle) :
+		rigidBody(rigidBody), impulse(impulse), refrHandle(refrHandle) {}
+
+	virtual void Run() override
+	{
+		if (NiPointer<TESObjectREFR> refr; LookupREFRByHandle(refrHandle, refr)) {
+			NiPointer<NiNode> root = refr->GetNiNode();
+			if (root && FindRigidBody(root, rigidBody)) {
+				if (IsMoveableEntity(rigidBody)) {
+					hkpEntity_activate(rigidBody);
+					rigidBody->m_motion.applyLinearImpulse(NiPointToHkVector(impulse));
+				}
+			}
+		}
+	}
+};
+
+struct OldJobs
+{
+	std::vector<std::unique_ptr<GenericJob>> jobs{};
+
+	void QueuePointImpulse(hkpRigidBody *rigidBody, const NiPoint3 &point, const NiPoint3 &impulse, UInt32 refrHandle)
+	{
+		jobs.push_back(std::make_unique<PointImpulseJob>(rigidBody, point, impulse, refrHandle));
+	}
+
+	void QueueLinearImpulse(hkpRigidBody *rigidBody, const NiPoint3 &impulse, UInt32 refrHandle)
+	{
+		jobs.push_back(std::make_unique<LinearImpulseJob>(rigidBody, impulse, refrHandle));
+	}
+
+	void Run()
+	{
+		for (auto &job : jobs) {
+			job.get()->Run();
+		}
+		jobs.clear();
+	}
+};
+
+// Also makes the scene the one that handles are looked up in, for the Run() that follows
+template <typename Jobs>
+static void Queue(Jobs &jobs, const Scene &scene, const std::vector<Impulse> &impulses)
+{
+	g_scene = &scene;
+	for (const Impulse &impulse : impulses) {
+		hkpRigidBody *rigidBody = scene.refrBodies[impulse.actor][impulse.bodyIndex];
+		if (impulse.isPoint) {
+			jobs.QueuePointImpulse(rigidBody, impulse.point, impulse.impulse, impulse.actor);
+		}
+		else {
+			jobs.QueueLinearImpulse(rigidBody, impulse.impulse, impulse.actor);
+		}
+	}
+}
+
+static float GetMaxError(const Scene &expected, const Scene &actual)
+{
+	float maxError = 0.f;
+	for (size_t i = 0; i < expected.bodies.size(); i++) {
+		const hkpRigidBody &a = *expected.bodies[i];
+		const hkpRigidBody &b = *actual.bodies[i];
+		const float *va[] = { a.m_motion.m_linearVelocity.v, a.m_motion.m_angularVelocity.v };
+		const float *vb[] = { b.m_motion.m_linearVelocity.v, b.m_motion.m_angularVelocity.v };
+		for (int v = 0; v < 2; v++) {
+			for (int j = 0; j < 3; j++) {
+				float error = fabsf(va[v][j] - vb[v][j]) / fmaxf(1.f, fabsf(va[v][j]));
+				if (!(error <= maxError)) maxError = error; // also catches nan
+			}
+		}
+		if (a.m_isActive != b.m_isActive) maxError = INFINITY;
+	}
+	return maxError;
+}
+
+// Queues and applies the impulses once per iteration, like one physics step, and returns the time per impulse in ns
+template <typename Jobs>
+static double Time(Jobs &jobs, const Scene &scene, const std::vector<Impulse> &impulses, int iterations)
+{
+	// Warm up, so that neither path is timed while it's still growing its allocations
+	Queue(jobs, scene, impulses);
+	jobs.Run();
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++) {
+		Queue(jobs, scene, impulses);
+		jobs.Run();
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double seconds = std::chrono::duration<double>(end - start).count();
+	return seconds * 1e9 / ((double)impulses.size() * iterations);
+}
+
+int main(int argc, char **argv)
+{
+	int numActors = 20;
+	int iterations = 200;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--actors") && i + 1 < argc) numActors = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+		else {
+			fprintf(stderr, "Usage: %s [--actors n] [--iterations n]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (numActors <= 0 || iterations <= 0) {
+		fprintf(stderr, "Counts must be positive\n");
+		return 1;
+	}
+
+	int numFailed = 0;
+	for (int numImpulses : { 1000, 10000 }) {
+		// One step on fresh scenes, to check that both paths end up with the same velocities
+		Scene oldScene, newScene;
+		MakeScene(oldScene, numActors, 42);
+		MakeScene(newScene, numActors, 42);
+		std::vector<Impulse> impulses = MakeImpulses(oldScene, numImpulses, 7);
+
+		OldJobs oldJobs;
+		Queue(oldJobs, oldScene, impulses);
+		oldJobs.Run();
+
+		PrePhysicsJobs newJobs;
+		Queue(newJobs, newScene, impulses);
+		newJobs.Run();
+
+		float maxError = GetMaxError(oldScene, newScene);
+		bool isMatch = maxError <= g_tolerance;
+		if (!isMatch) ++numFailed;
+
+		double oldTime = Time(oldJobs, oldScene, impulses, iterations);
+		double newTime = Time(newJobs, newScene, impulses, iterations);
+
+		printf("%5d impulses on %d actors: %s (max error %g)\n", numImpulses, numActors, isMatch ? "velocities match" : "velocities do NOT match", maxError);
+		printf("  job per impulse   %8.2f ns per impulse\n", oldTime);
+		printf("  summed per body   %8.2f ns per impulse, %.2fx\n", newTime, oldTime / newTime);
+	}
+
+	return numFailed ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Stand-in for the base havok header, so that src/pose_blend.cpp builds on its own for tools/pose_blend_bench.cpp, and for the other havok stand-ins.
+// Only the layout matters: translation, rotation, scale, 4 floats each.
+
+#include <cstdint>
+
+typedef std::uint8_t UInt8;
+typedef std::uint16_t UInt16;
+typedef std::uint32_t UInt32;
+typedef std::uint64_t UInt64;
+
+struct alignas(16) hkVector4
+{
+	float v[4];
+};
+
+struct alignas(16) hkQuaternion
+{
+	hkVector4 m_vec;
+};
+
+struct alignas(16) hkQsTransform
+{
+	hkVector4 m_translation;
+	hkQuaternion m_rotation;
+	hkVector4 m_scale;
+};
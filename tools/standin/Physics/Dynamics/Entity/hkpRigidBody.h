@@ -0,0 +1,51 @@
+#pragma once
+
+// Stand-in for the havok rigid body, with just the motion state that PrePhysicsJobs reads and writes, so that src/pre_physics_jobs.cpp builds on its own
+// for tools/pre_physics_jobs_bench.cpp. The inertia is diagonal in world space, so an angular impulse is just scaled per axis.
+
+#include <Common/Base/hkBase.h>
+
+
+struct hkpMotion
+{
+	enum MotionType : UInt8
+	{
+		MOTION_INVALID,
+		MOTION_DYNAMIC,
+		MOTION_SPHERE_INERTIA,
+		MOTION_BOX_INERTIA,
+		MOTION_KEYFRAMED,
+		MOTION_FIXED,
+	};
+
+	UInt8 m_type = MOTION_DYNAMIC;
+	hkVector4 m_centerOfMass{}; // in world space
+	hkVector4 m_inertiaAndMassInv{}; // inverse inertia in xyz, inverse mass in w
+	hkVector4 m_linearVelocity{};
+	hkVector4 m_angularVelocity{};
+
+	void applyLinearImpulse(const hkVector4 &impulse)
+	{
+		for (int i = 0; i < 3; i++) {
+			m_linearVelocity.v[i] += impulse.v[i] * m_inertiaAndMassInv.v[3];
+		}
+	}
+
+	void applyAngularImpulse(const hkVector4 &impulse)
+	{
+		for (int i = 0; i < 3; i++) {
+			m_angularVelocity.v[i] += impulse.v[i] * m_inertiaAndMassInv.v[i];
+		}
+	}
+};
+
+struct hkpEntity
+{
+	hkpMotion m_motion;
+	bool m_isActive = false; // stands in for the simulation island's activation state
+};
+
+struct hkpRigidBody : hkpEntity
+{
+	const hkVector4 & getCenterOfMassInWorld() const { return m_motion.m_centerOfMass; }
+};
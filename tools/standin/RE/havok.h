@@ -0,0 +1,8 @@
+#pragma once
+
+// Stand-in for the plugin's RE/havok.h, with what src/pre_physics_jobs.cpp uses from it, for tools/pre_physics_jobs_bench.cpp.
+
+#include <Physics/Dynamics/Entity/hkpRigidBody.h>
+
+
+inline bool IsMoveableEntity(hkpEntity *entity) { return entity->m_motion.m_type != hkpMotion::MOTION_KEYFRAMED && entity->m_motion.m_type != hkpMotion::MOTION_FIXED; }
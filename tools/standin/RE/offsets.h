@@ -0,0 +1,8 @@
+#pragma once
+
+// Stand-in for the plugin's RE/offsets.h, with what src/pre_physics_jobs.cpp uses from it, for tools/pre_physics_jobs_bench.cpp.
+
+#include <Physics/Dynamics/Entity/hkpRigidBody.h>
+
+
+inline void hkpEntity_activate(hkpEntity *entity) { entity->m_isActive = true; }
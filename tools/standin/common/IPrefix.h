@@ -0,0 +1,11 @@
+#pragma once
+
+// Stand-in for the skse prefix header that the plugin force-includes, with just the integer types, so that sources that rely on it
+// can be built on their own the same way (-include common/IPrefix.h).
+
+#include <cstdint>
+
+typedef std::uint8_t UInt8;
+typedef std::uint16_t UInt16;
+typedef std::uint32_t UInt32;
+typedef std::uint64_t UInt64;
@@ -0,0 +1,15 @@
+#pragma once
+
+// Stand-in for the plugin's config, with only what src/collision_filter_table.cpp reads.
+// Has to come before ../include on the include path.
+
+namespace Config {
+	struct Options
+	{
+		bool doBipedNonSelfCollision = false;
+		bool enablePlayerBipedCollision = true;
+	};
+
+	extern Options options;
+	extern UInt32 optionsVersion;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+// Stand-in for the plugin's math_utils.h, with what src/pre_physics_jobs.cpp uses from it, for tools/pre_physics_jobs_bench.cpp.
+
+#include <Common/Base/hkBase.h>
+
+#include "skse64/NiTypes.h"
+
+
+NiPoint3 CrossProduct(const NiPoint3 &vec1, const NiPoint3 &vec2);
+
+inline NiPoint3 HkVectorToNiPoint(const hkVector4 &vec) { return { vec.v[0], vec.v[1], vec.v[2] }; }
+inline hkVector4 NiPointToHkVector(const NiPoint3 &pt) { return { { pt.x, pt.y, pt.z, 0 } }; }
@@ -0,0 +1,21 @@
+#pragma once
+
+// Stand-in for the skse header, with the collision layers the collision filter policy looks at, so that src/collision_filter_table.cpp builds on its own
+// for tools/collision_filter_check.cpp.
+
+#include <cstdint>
+
+typedef std::uint8_t UInt8;
+typedef std::uint16_t UInt16;
+typedef std::uint32_t UInt32;
+typedef std::uint64_t UInt64;
+
+struct BGSCollisionLayer
+{
+	enum
+	{
+		kCollisionLayer_Biped = 8,
+		kCollisionLayer_CharController = 30,
+		kCollisionLayer_BipedNoCC = 33,
+	};
+};
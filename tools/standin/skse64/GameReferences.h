@@ -0,0 +1,18 @@
+#pragma once
+
+// Stand-in for the skse header. higgsinterface001.h only needs declarations from it; tools/pre_physics_jobs_bench.cpp needs a refr with its 3d,
+// and a handle lookup that the bench defines over its own scene.
+
+#include "common/IPrefix.h"
+#include "skse64/NiNodes.h"
+
+
+class TESObjectREFR
+{
+public:
+	NiNode *m_root = nullptr;
+
+	NiNode * GetNiNode() { return m_root; }
+};
+
+bool LookupREFRByHandle(UInt32 &refHandle, NiPointer<TESObjectREFR> &refrOut);
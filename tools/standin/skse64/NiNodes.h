@@ -0,0 +1,30 @@
+#pragma once
+
+// Stand-in for the skse scene graph, for tools/pre_physics_jobs_bench.cpp. A node's collision object and the havok body behind it are
+// collapsed into a rigid body pointer.
+
+#include <vector>
+
+#include <Physics/Dynamics/Entity/hkpRigidBody.h>
+
+#include "skse64/NiTypes.h"
+
+
+class NiNode;
+
+class NiAVObject
+{
+public:
+	hkpRigidBody *m_rigidBody = nullptr;
+
+	virtual ~NiAVObject() = default;
+	virtual NiNode * GetAsNiNode() { return nullptr; }
+};
+
+class NiNode : public NiAVObject
+{
+public:
+	std::vector<NiAVObject *> m_children;
+
+	virtual NiNode * GetAsNiNode() override { return this; }
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+// Stand-in for the skse header, with NiPoint3 and a NiPointer that doesn't count references, for tools/pre_physics_jobs_bench.cpp.
+
+
+class NiPoint3
+{
+public:
+	float x, y, z;
+
+	NiPoint3() : x(0.f), y(0.f), z(0.f) {}
+	NiPoint3(float x, float y, float z) : x(x), y(y), z(z) {}
+
+	NiPoint3 operator+(const NiPoint3 &other) const { return NiPoint3(x + other.x, y + other.y, z + other.z); }
+	NiPoint3 operator-(const NiPoint3 &other) const { return NiPoint3(x - other.x, y - other.y, z - other.z); }
+	NiPoint3 operator*(float scalar) const { return NiPoint3(x * scalar, y * scalar, z * scalar); }
+	NiPoint3 & operator+=(const NiPoint3 &other) { x += other.x; y += other.y; z += other.z; return *this; }
+};
+
+template <class T>
+class NiPointer
+{
+public:
+	T *m_pObject;
+
+	NiPointer(T *object = nullptr) : m_pObject(object) {}
+
+	NiPointer & operator=(T *object) { m_pObject = object; return *this; }
+	operator T *() const { return m_pObject; }
+	T * operator->() const { return m_pObject; }
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+// Stand-in for the skse header, with just the declarations higgsinterface001.h needs to compile.
+
+#include <cstdint>
+
+typedef std::uint8_t UInt8;
+typedef std::uint16_t UInt16;
+typedef std::uint32_t UInt32;
+typedef std::uint64_t UInt64;
+
+typedef UInt32 PluginHandle;
+struct SKSEMessagingInterface;
+class TESForm;
+class TESObjectREFR;
+class NiObject;
@@ -0,0 +1,11 @@
+#pragma once
+
+// Stand-in for the plugin's utils.h, with what src/pre_physics_jobs.cpp uses from it, for tools/pre_physics_jobs_bench.cpp.
+
+#include <functional>
+
+#include "skse64/NiNodes.h"
+#include "skse64/GameReferences.h"
+
+
+void ForEachRigidBody(NiAVObject *root, std::function<void(hkpRigidBody *)> f);
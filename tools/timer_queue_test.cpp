@@ -0,0 +1,243 @@
+// Tests for TimerQueue and InlineJob (src/timer_queue.cpp), mostly the cases that are easy to get wrong with reused slots and lazy cancellation:
+// ties between jobs due at the same time, cancelling with a token whose job has already run, a job rescheduling itself into the slot it was just
+// released from, and Clear() from inside a running job.
+//
+// Builds on its own, outside of the plugin, with a stand-in for the prefix header the plugin force-includes:
+//   g++ -std=c++17 -O2 -Istandin -include common/IPrefix.h -I../include timer_queue_test.cpp ../src/timer_queue.cpp -o timer_queue_test
+//
+// Usage:
+//   timer_queue_test
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "timer_queue.h"
+
+
+static int g_numFailed = 0;
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			printf("%s:%d: check failed: %s\n", __func__, __LINE__, #condition); \
+			++g_numFailed; \
+		} \
+	} while (0)
+
+static void TestFifoTies()
+{
+	TimerQueue queue;
+	std::vector<int> order;
+
+	// Same run time, scheduled out of order with earlier and later ones in between
+	for (int i = 0; i < 8; i++) {
+		queue.Schedule([&order, i] { order.push_back(i); }, 1.0);
+		queue.Schedule([&order, i] { order.push_back(100 + i); }, i % 2 ? 0.5 : 2.0);
+	}
+
+	queue.Run(1.0, 0.0);
+	std::vector<int> expected{ 101, 103, 105, 107, 0, 1, 2, 3, 4, 5, 6, 7 };
+	CHECK(order == expected);
+	CHECK(queue.size() == 4);
+
+	order.clear();
+	queue.Run(2.0, 0.0);
+	expected = { 100, 102, 104, 106 };
+	CHECK(order == expected);
+	CHECK(queue.empty());
+}
+
+static void TestClocks()
+{
+	TimerQueue queue;
+	std::vector<int> order;
+
+	queue.Schedule([&order] { order.push_back(1); }, 1.0, TimerClock::Real);
+	queue.Schedule([&order] { order.push_back(2); }, 1.0, TimerClock::Game);
+
+	queue.Run(0.5, 1.0);
+	CHECK(order == std::vector<int>{ 2 });
+
+	queue.Run(1.0, 0.0);
+	CHECK((order == std::vector<int>{ 2, 1 }));
+	CHECK(queue.empty());
+}
+
+static void TestCancel()
+{
+	TimerQueue queue;
+	int numRuns = 0;
+
+	TimerToken token = queue.Schedule([&numRuns] { ++numRuns; }, 1.0);
+	CHECK(queue.IsPending(token));
+	CHECK(queue.Cancel(token));
+	CHECK(!queue.IsPending(token));
+	CHECK(!queue.Cancel(token));
+	CHECK(queue.empty());
+
+	queue.Run(1.0, 1.0);
+	CHECK(numRuns == 0);
+
+	// A default token never matches anything
+	queue.Schedule([&numRuns] { ++numRuns; }, 1.0);
+	CHECK(!queue.IsPending(TimerToken{}));
+	CHECK(!queue.Cancel(TimerToken{}));
+	queue.Run(1.0, 1.0);
+	CHECK(numRuns == 1);
+}
+
+static void TestCancelAfterRun()
+{
+	TimerQueue queue;
+	int numRuns = 0;
+
+	TimerToken token = queue.Schedule([&numRuns] { ++numRuns; }, 1.0);
+	queue.Run(1.0, 0.0);
+	CHECK(numRuns == 1);
+	CHECK(!queue.IsPending(token));
+	CHECK(!queue.Cancel(token));
+
+	// The next job reuses the slot. The stale token must not cancel it.
+	TimerToken newToken = queue.Schedule([&numRuns] { ++numRuns; }, 2.0);
+	CHECK(newToken.slot == token.slot);
+	CHECK(newToken.generation != token.generation);
+	CHECK(!queue.Cancel(token));
+	CHECK(queue.IsPending(newToken));
+
+	queue.Run(2.0, 0.0);
+	CHECK(numRuns == 2);
+}
+
+static void TestCancelFromEarlierJob()
+{
+	TimerQueue queue;
+	std::vector<int> order;
+
+	// Both are due in the same Run(); the first one cancels the second
+	TimerToken second;
+	queue.Schedule([&] { order.push_back(1); CHECK(queue.Cancel(second)); }, 1.0);
+	second = queue.Schedule([&order] { order.push_back(2); }, 1.0);
+
+	queue.Run(1.0, 0.0);
+	CHECK(order == std::vector<int>{ 1 });
+	CHECK(queue.empty());
+}
+
+static void TestRescheduleIntoOwnSlot()
+{
+	TimerQueue queue;
+	TimerToken tokens[4];
+	int numRuns = 0;
+
+	// A repeating job: each run schedules the next one, which gets the slot the running job was just released from
+	struct Repeat
+	{
+		TimerQueue &queue;
+		TimerToken *tokens;
+		int &numRuns;
+
+		void operator()()
+		{
+			++numRuns;
+			if (numRuns < 4) {
+				tokens[numRuns] = queue.Schedule(Repeat{ *this }, numRuns + 1.0);
+			}
+		}
+	};
+
+	tokens[0] = queue.Schedule(Repeat{ queue, tokens, numRuns }, 1.0);
+
+	// Jobs scheduled by a running job wait for the next Run(), even if they are already due
+	queue.Run(10.0, 0.0);
+	CHECK(numRuns == 1);
+	CHECK(tokens[1].slot == tokens[0].slot);
+	CHECK(tokens[1].generation != tokens[0].generation);
+	CHECK(!queue.IsPending(tokens[0]));
+	CHECK(queue.IsPending(tokens[1]));
+
+	queue.Run(10.0, 0.0);
+	queue.Run(10.0, 0.0);
+	CHECK(numRuns == 3);
+	CHECK(tokens[3].slot == tokens[0].slot);
+
+	// Cancelling with the token of an earlier run doesn't stop the current one
+	CHECK(!queue.Cancel(tokens[1]));
+	CHECK(queue.Cancel(tokens[3]));
+	queue.Run(10.0, 0.0);
+	CHECK(numRuns == 3);
+	CHECK(queue.empty());
+}
+
+static void TestClearFromJob()
+{
+	TimerQueue queue;
+	std::vector<int> order;
+
+	queue.Schedule([&order] { order.push_back(1); }, 1.0);
+	queue.Schedule([&] { order.push_back(2); queue.Clear(); }, 1.0);
+	queue.Schedule([&order] { order.push_back(3); }, 1.0); // due in the same run, after the clear
+	queue.Schedule([&order] { order.push_back(4); }, 2.0);
+	queue.Schedule([&order] { order.push_back(5); }, 1.0, TimerClock::Game);
+
+	queue.Run(1.0, 1.0);
+	CHECK((order == std::vector<int>{ 1, 2 }));
+	CHECK(queue.empty());
+
+	queue.Run(2.0, 2.0);
+	CHECK((order == std::vector<int>{ 1, 2 }));
+
+	// The queue still works after being cleared, and reuses the released slots
+	TimerToken token = queue.Schedule([&order] { order.push_back(6); }, 3.0);
+	CHECK(token.slot < 5);
+	queue.Run(3.0, 3.0);
+	CHECK((order == std::vector<int>{ 1, 2, 6 }));
+}
+
+static void TestInlineJob()
+{
+	// Captures are destroyed exactly once, whether they're stored inline or on the heap, and whether the job runs, is cancelled or is cleared
+	auto counter = std::make_shared<int>(0);
+	{
+		TimerQueue queue;
+		std::string big(200, 'x');
+		queue.Schedule([counter] { ++*counter; }, 1.0);
+		queue.Schedule([counter, big] { *counter += (int)big.size(); }, 1.0);
+		queue.Cancel(queue.Schedule([counter] { ++*counter; }, 1.0));
+		queue.Schedule([counter] { ++*counter; }, 2.0);
+		CHECK(counter.use_count() == 4);
+
+		queue.Run(1.0, 0.0);
+		CHECK(*counter == 201);
+		CHECK(counter.use_count() == 2);
+
+		queue.Clear();
+		CHECK(counter.use_count() == 1);
+
+		queue.Schedule([counter] { ++*counter; }, 1.0);
+	}
+	CHECK(counter.use_count() == 1);
+
+	InlineJob job([counter] { ++*counter; });
+	InlineJob moved = std::move(job);
+	CHECK(!job);
+	CHECK(moved);
+	moved();
+	CHECK(*counter == 202);
+}
+
+int main()
+{
+	TestFifoTies();
+	TestClocks();
+	TestCancel();
+	TestCancelAfterRun();
+	TestCancelFromEarlierJob();
+	TestRescheduleIntoOwnSlot();
+	TestClearFromJob();
+	TestInlineJob();
+
+	printf("%s\n", g_numFailed ? "FAILED" : "all checks passed");
+	return g_numFailed ? 1 : 0;
+}